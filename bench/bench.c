@@ -0,0 +1,387 @@
+/**
+ * @file	bench.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	End-to-end benchmark of lz78 compression and decompression.
+ *
+ * Generates the corpora of corpus.h, then runs the lz78 executable on each
+ * of them for every dictionary and hash table size, a few times each, and
+ * reports throughput (median and 90th percentile of the run times), ratio
+ * and peak resident memory as a table and, optionally, as JSON.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "corpus.h"
+
+#define MAX_SIZES		16					/**< Maximum number of dictionary (or table) sizes. */
+#define MAX_ARGS		32					/**< Maximum number of arguments of an lz78 run. */
+#define MAX_RUNS		1000				/**< Maximum number of runs of each measure. */
+#define PATH_LEN		4096				/**< Size of the buffers of file names. */
+
+const char *help = "\
+Usage: lz78_bench [-x <lz78>] [-w <work_dir>] [-b <corpus_size>] [-n <runs>] [-c <corpora>] [-s <dict_sizes>] [-t <table_sizes>] [-a <lz78_options>] [-j <json_file>]\n\n\
+\
+  -x <lz78>         lz78 executable to be measured (default ./lz78)\n\
+  -w <work_dir>     directory for the corpora and the outputs (default bench_work)\n\
+  -b <corpus_size>  size of each corpus in bytes (default 4194304); the tiny corpus is 1/16 of it\n\
+  -n <runs>         runs of each measure (default 5)\n\
+  -c <corpora>      comma separated corpora (default text,log,binary,random,repetitive,tiny)\n\
+  -s <dict_sizes>   comma separated dictionary sizes (default 4096,65536,1048576)\n\
+  -t <table_sizes>  comma separated hash table sizes, 0 for the lz78 default (default 0)\n\
+  -a <options>      further lz78 compression options, space separated (e.g. \"-e -r recycle\")\n\
+  -j <json_file>    also write the results as JSON to <json_file>\n\n";
+
+/**
+ * Summary of the runs of a measure.
+ */
+struct measure {
+	double		min;	/**< Fastest run, in ms. */
+	double		p50;	/**< Median run, in ms. */
+	double		p90;	/**< 90th percentile of the runs, in ms. */
+	double		max;	/**< Slowest run, in ms. */
+	long		rss;	/**< Peak resident set size of a run, in kB. */
+};
+
+/**
+ * Runs @p argv, and adds to @p rss the peak resident set size of the child if
+ * it is larger.
+ *
+ *	@return	@c 0 if the child exited successfully, @c -1 otherwise.
+ */
+static int spawn(char* const* argv, long* rss) {
+
+	struct rusage	usage;
+	pid_t			pid;
+	int				status;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	if (wait4(pid, &status, 0, &usage) < 0)
+		return -1;
+	if (usage.ru_maxrss > *rss)
+		*rss = usage.ru_maxrss;
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+/**
+ * Returns the time elapsed since @p t0, in ms.
+ */
+static double elapsed(const struct timespec* t0) {
+
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+static int cmp_double(const void* a, const void* b) {
+
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Fills @p m with the statistics of the @p n run times @p t (sorted on return).
+ */
+static void summarize(double* t, int n, struct measure* m) {
+
+	qsort(t, n, sizeof(*t), cmp_double);
+	m->min = t[0];
+	m->p50 = t[(n - 1) / 2];
+	m->p90 = t[(n * 9 + 9) / 10 - 1]; // nearest rank
+	m->max = t[n - 1];
+}
+
+/**
+ * Returns the size of file @p path, or @c -1 on failure.
+ */
+static int64_t file_size(const char* path) {
+
+	struct stat file_stat;
+
+	if (stat(path, &file_stat) < 0)
+		return -1;
+	return file_stat.st_size;
+}
+
+/**
+ * Returns @c 1 if files @p a and @p b have the same content, @c 0 otherwise.
+ */
+static int same_file(const char* a, const char* b) {
+
+	FILE	*fa = fopen(a, "r"), *fb = fopen(b, "r");
+	char	ba[65536], bb[65536];
+	size_t	na, nb;
+	int		same = fa != NULL && fb != NULL;
+
+	while (same) {
+		na = fread(ba, 1, sizeof(ba), fa);
+		nb = fread(bb, 1, sizeof(bb), fb);
+		same = na == nb && memcmp(ba, bb, na) == 0;
+		if (na == 0)
+			break;
+	}
+
+	if (fa != NULL)
+		fclose(fa);
+	if (fb != NULL)
+		fclose(fb);
+	return same;
+}
+
+/**
+ * Splits @p list at commas into at most @p max numbers, and returns how many.
+ */
+static int parse_sizes(char* list, uint32_t* sizes, int max) {
+
+	char	*tok;
+	int		n = 0;
+
+	for (tok = strtok(list, ","); tok != NULL && n < max; tok = strtok(NULL, ","))
+		sizes[n++] = strtoul(tok, NULL, 10);
+	return n;
+}
+
+/**
+ * Prints measure @p m of operation @p name as a JSON object to @p f.
+ */
+static void json_measure(FILE* f, const char* name, const struct measure* m, uint64_t bytes) {
+
+	fprintf(f, "\"%s\": {\"time_ms\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"max\": %.3f}, "
+			"\"mbps_p50\": %.3f, \"mbps_p90\": %.3f, \"rss_kb\": %ld}",
+			name, m->min, m->p50, m->p90, m->max,
+			bytes / (m->p50 / 1e3) / (1024*1024), bytes / (m->p90 / 1e3) / (1024*1024), m->rss);
+}
+
+int main(int argc, char* argv[]) {
+
+	const char		*exe = "./lz78", *work = "bench_work", *json_name = NULL;
+	char			*corpora = NULL, *options = NULL, *tok, *save;
+	char			path[PATH_LEN], cpath[PATH_LEN + 8], dpath[PATH_LEN + 8], sarg[16], targ[16];
+	char			*args[MAX_ARGS], *opt_args[MAX_ARGS];
+	uint32_t		dict_sizes[MAX_SIZES] = { 4096, 65536, 1048576 }, table_sizes[MAX_SIZES] = { 0 };
+	int				n_dict = 3, n_table = 1, n_opts = 0, runs = 5, c, i, j, k, r, f, files, first = 1;
+	uint64_t		corpus_size = 4 * 1024 * 1024, bytes, compressed;
+	double			*times;
+	struct measure	cm, dm;
+	struct timespec	t0;
+	FILE			*json = NULL;
+
+	while ((c = getopt(argc, argv, "a:b:c:hj:n:s:t:w:x:")) != -1) {
+		switch (c) {
+			case 'a':
+				options = optarg;
+				break;
+			case 'b':
+				corpus_size = strtoull(optarg, NULL, 10);
+				break;
+			case 'c':
+				corpora = optarg;
+				break;
+			case 'j':
+				json_name = optarg;
+				break;
+			case 'n':
+				runs = atoi(optarg);
+				break;
+			case 's':
+				n_dict = parse_sizes(optarg, dict_sizes, MAX_SIZES);
+				break;
+			case 't':
+				n_table = parse_sizes(optarg, table_sizes, MAX_SIZES);
+				break;
+			case 'w':
+				work = optarg;
+				break;
+			case 'x':
+				exe = optarg;
+				break;
+			case 'h':
+				printf("%s", help);
+				exit(EXIT_SUCCESS);
+			default:
+				fprintf(stderr, "%s", help);
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	if (runs < 1 || runs > MAX_RUNS || n_dict == 0 || n_table == 0 || corpus_size == 0) {
+		fprintf(stderr, "%s: Invalid arguments\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	for (tok = options != NULL ? strtok_r(options, " ", &save) : NULL; tok != NULL && n_opts < MAX_ARGS - 12; tok = strtok_r(NULL, " ", &save))
+		opt_args[n_opts++] = tok;
+
+	if (mkdir(work, 0755) < 0 && errno != EEXIST) {
+		perror(work);
+		exit(EXIT_FAILURE);
+	}
+
+	if (json_name != NULL) {
+		json = fopen(json_name, "w");
+		if (json == NULL) {
+			perror(json_name);
+			exit(EXIT_FAILURE);
+		}
+		fprintf(json, "{\"lz78\": \"%s\", \"options\": \"", exe);
+		for (i = 0; i < n_opts; i++)
+			fprintf(json, "%s%s", i > 0 ? " " : "", opt_args[i]);
+		fprintf(json, "\", \"runs\": %d, \"corpus_size\": %llu, \"results\": [\n", runs, (unsigned long long)corpus_size);
+	}
+
+	times = malloc(sizeof(*times) * runs);
+	if (times == NULL)
+		exit(EXIT_FAILURE);
+
+	printf("%-10s %9s %9s %9s %7s %9s %9s %9s %9s %9s %9s\n", "corpus", "dict", "table", "input_kB", "ratio",
+			"c_MB/s", "c_p90_ms", "c_rss_kB", "d_MB/s", "d_p90_ms", "d_rss_kB");
+
+	for (i = 0; corpus_names[i] != NULL; i++) {
+		if (corpora != NULL) { // is it in the list?
+			char *found = strstr(corpora, corpus_names[i]);
+			size_t len = strlen(corpus_names[i]);
+
+			if (found == NULL || (found != corpora && found[-1] != ',') || (found[len] != '\0' && found[len] != ','))
+				continue;
+		}
+
+		files = corpus_generate(work, corpus_names[i], strcmp(corpus_names[i], "tiny") == 0 ? corpus_size / 16 : corpus_size);
+		if (files < 0) {
+			perror(corpus_names[i]);
+			exit(EXIT_FAILURE);
+		}
+		for (f = 0, bytes = 0; f < files; f++) {
+			corpus_path(path, sizeof(path), work, corpus_names[i], f, files);
+			bytes += file_size(path);
+		}
+
+		for (j = 0; j < n_dict; j++) {
+			for (k = 0; k < n_table; k++) {
+				if (table_sizes[k] != 0 && table_sizes[k] < dict_sizes[j])
+					continue;
+				snprintf(sarg, sizeof(sarg), "%u", dict_sizes[j]);
+				snprintf(targ, sizeof(targ), "%u", table_sizes[k]);
+
+				// compress every file of the corpus, runs times
+				cm.rss = 0;
+				for (r = 0; r < runs; r++) {
+					clock_gettime(CLOCK_MONOTONIC, &t0);
+					for (f = 0; f < files; f++) {
+						int a = 0, o;
+
+						corpus_path(path, sizeof(path), work, corpus_names[i], f, files);
+						snprintf(cpath, sizeof(cpath), "%s.lz78", path);
+						args[a++] = (char*)exe;
+						args[a++] = "-c";
+						args[a++] = "-s";
+						args[a++] = sarg;
+						if (table_sizes[k] != 0) {
+							args[a++] = "-t";
+							args[a++] = targ;
+						}
+						for (o = 0; o < n_opts; o++)
+							args[a++] = opt_args[o];
+						args[a++] = "-i";
+						args[a++] = path;
+						args[a++] = "-o";
+						args[a++] = cpath;
+						args[a] = NULL;
+						if (spawn(args, &cm.rss) < 0) {
+							fprintf(stderr, "%s: Compression of %s failed\n", argv[0], path);
+							exit(EXIT_FAILURE);
+						}
+					}
+					times[r] = elapsed(&t0);
+				}
+				summarize(times, runs, &cm);
+
+				// decompress them, runs times
+				dm.rss = 0;
+				for (r = 0; r < runs; r++) {
+					clock_gettime(CLOCK_MONOTONIC, &t0);
+					for (f = 0; f < files; f++) {
+						corpus_path(path, sizeof(path), work, corpus_names[i], f, files);
+						snprintf(cpath, sizeof(cpath), "%s.lz78", path);
+						snprintf(dpath, sizeof(dpath), "%s.out", path);
+						args[0] = (char*)exe;
+						args[1] = "-d";
+						args[2] = "-i";
+						args[3] = cpath;
+						args[4] = "-o";
+						args[5] = dpath;
+						args[6] = NULL;
+						if (spawn(args, &dm.rss) < 0) {
+							fprintf(stderr, "%s: Decompression of %s failed\n", argv[0], cpath);
+							exit(EXIT_FAILURE);
+						}
+					}
+					times[r] = elapsed(&t0);
+				}
+				summarize(times, runs, &dm);
+
+				// check the outputs and clean up
+				for (f = 0, compressed = 0; f < files; f++) {
+					corpus_path(path, sizeof(path), work, corpus_names[i], f, files);
+					snprintf(cpath, sizeof(cpath), "%s.lz78", path);
+					snprintf(dpath, sizeof(dpath), "%s.out", path);
+					if (!same_file(path, dpath)) {
+						fprintf(stderr, "%s: Decompressed %s differs from the original\n", argv[0], dpath);
+						exit(EXIT_FAILURE);
+					}
+					compressed += file_size(cpath);
+					unlink(cpath);
+					unlink(dpath);
+				}
+
+				printf("%-10s %9u %9u %9.0f %7.3f %9.2f %9.1f %9ld %9.2f %9.1f %9ld\n", corpus_names[i], dict_sizes[j], table_sizes[k],
+						bytes / 1024.0, (double)bytes / compressed,
+						bytes / (cm.p50 / 1e3) / (1024*1024), cm.p90, cm.rss,
+						bytes / (dm.p50 / 1e3) / (1024*1024), dm.p90, dm.rss);
+				fflush(stdout);
+
+				if (json != NULL) {
+					fprintf(json, "%s  {\"corpus\": \"%s\", \"files\": %d, \"bytes\": %llu, \"dict_size\": %u, \"table_size\": %u, "
+							"\"compressed\": %llu, \"ratio\": %.4f, ", first ? "" : ",\n", corpus_names[i], files,
+							(unsigned long long)bytes, dict_sizes[j], table_sizes[k], (unsigned long long)compressed, (double)bytes / compressed);
+					json_measure(json, "compress", &cm, bytes);
+					fprintf(json, ", ");
+					json_measure(json, "decompress", &dm, bytes);
+					fprintf(json, "}");
+					first = 0;
+				}
+			}
+		}
+
+		for (f = 0; f < files; f++) {
+			corpus_path(path, sizeof(path), work, corpus_names[i], f, files);
+			unlink(path);
+		}
+	}
+
+	if (json != NULL) {
+		fprintf(json, "\n]}\n");
+		fclose(json);
+	}
+	free(times);
+
+	exit(EXIT_SUCCESS);
+}
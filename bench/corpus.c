@@ -0,0 +1,314 @@
+/**
+ * @file	corpus.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for the generator of the benchmark corpora.
+ * @internal
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "corpus.h"
+
+#define VOCABULARY	4096	/**< Number of words of the text corpus. */
+#define BLOCKS		16		/**< Number of distinct blocks of the repetitive corpus. */
+
+const char* const corpus_names[] = { "text", "log", "binary", "random", "repetitive", "tiny", NULL };
+
+/**
+ * State of the xorshift64* generator of a corpus.
+ * @internal
+ */
+static uint64_t rng_state;
+
+/**
+ * Returns the next pseudo-random number.
+ * @internal
+ */
+static uint64_t rng(void) {
+
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Returns a pseudo-random number between 0 and (@p n - 1).
+ * @internal
+ */
+static uint32_t rng_below(uint32_t n) {
+
+	return (rng() >> 32) * n >> 32;
+}
+
+/**
+ * Returns a number between 0 and (@p n - 1), small numbers being far more
+ * likely (about a Zipf distribution).
+ * @internal
+ */
+static uint32_t rng_zipf(uint32_t n) {
+
+	double u = (double)(rng() >> 11) / (1ULL << 53);
+
+	return (uint32_t)(n * u * u * u * u);
+}
+
+/**
+ * Writes words of a Zipf distributed vocabulary, in sentences and lines.
+ * @internal
+ */
+static int gen_text(FILE* f, uint64_t size) {
+
+	static const char	letters[] = "etaoinshrdlcumwfgypbvkjxqz";
+	char				*words[VOCABULARY];
+	uint64_t			written = 0;
+	int					i, j, len, col = 0, sentence = 0;
+
+	for (i = 0; i < VOCABULARY; i++) {
+		len = 1 + rng_below(3) + rng_below(8);
+		words[i] = malloc(len + 1);
+		if (words[i] == NULL) {
+			while (i-- > 0)
+				free(words[i]);
+			return -1;
+		}
+		for (j = 0; j < len; j++)
+			words[i][j] = letters[rng_zipf(sizeof(letters) - 1)];
+		words[i][len] = '\0';
+	}
+
+	while (written < size) {
+		const char *w = words[rng_zipf(VOCABULARY)];
+
+		if (col > 72) {
+			fputc('\n', f);
+			written++;
+			col = 0;
+		}
+		else if (col > 0) {
+			fputc(' ', f);
+			written++;
+			col++;
+		}
+		if (sentence == 0)
+			fputc(w[0] - 'a' + 'A', f);
+		else
+			fputc(w[0], f);
+		fputs(w + 1, f);
+		len = strlen(w);
+		if (++sentence > 4 && rng_below(8) == 0) {
+			fputc('.', f);
+			len++;
+			sentence = 0;
+		}
+		written += len;
+		col += len;
+	}
+
+	for (i = 0; i < VOCABULARY; i++)
+		free(words[i]);
+	return 0;
+}
+
+/**
+ * Writes server log lines from a few templates.
+ * @internal
+ */
+static int gen_log(FILE* f, uint64_t size) {
+
+	static const char *levels[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+	static const char *components[] = { "http", "db", "auth", "cache", "scheduler" };
+	static const char *paths[] = { "/", "/login", "/api/v1/items", "/api/v1/users", "/static/app.js", "/health" };
+	uint64_t	written = 0, t = 1368500000000ULL;
+	int			n;
+
+	while (written < size) {
+		t += rng_below(2000);
+		n = fprintf(f, "2013-05-%02u %02u:%02u:%02u.%03u [%s] %s: ", (unsigned)(14 + t / 86400000 % 14),
+				(unsigned)(t / 3600000 % 24), (unsigned)(t / 60000 % 60), (unsigned)(t / 1000 % 60), (unsigned)(t % 1000),
+				levels[rng_below(6)], components[rng_below(5)]);
+		switch (rng_below(4)) {
+			case 0:
+				n += fprintf(f, "GET %s status=%u bytes=%u time=%ums\n", paths[rng_zipf(6)],
+						rng_below(16) == 0 ? 404 : 200, rng_below(100000), rng_zipf(2000));
+				break;
+			case 1:
+				n += fprintf(f, "query took %u ms rows=%u\n", rng_zipf(500), rng_zipf(10000));
+				break;
+			case 2:
+				n += fprintf(f, "session %016llx user=user%u ip=10.0.%u.%u\n", (unsigned long long)rng(),
+						rng_zipf(1000), rng_below(256), rng_below(256));
+				break;
+			default:
+				n += fprintf(f, "cache %s key=item:%u\n", rng_below(4) == 0 ? "miss" : "hit", rng_zipf(100000));
+		}
+		if (n < 0)
+			return -1;
+		written += n;
+	}
+	return 0;
+}
+
+/**
+ * Writes fixed size records of slowly changing fields, in host byte order.
+ * @internal
+ */
+static int gen_binary(FILE* f, uint64_t size) {
+
+	struct {
+		uint32_t	id;
+		uint32_t	time;
+		float		value;
+		uint16_t	flags;
+		uint16_t	sensor;
+	}			r = { 0, 1368500000, 20.0f, 0, 0 };
+	uint64_t	written;
+
+	for (written = 0; written < size; written += sizeof(r)) {
+		r.id++;
+		r.time += 1 + rng_below(3);
+		r.value += ((float)rng_below(201) - 100) / 1000;
+		r.flags = rng_below(32) == 0 ? 0x8001 : 0x0001;
+		r.sensor = rng_zipf(64);
+		if (fwrite(&r, sizeof(r), 1, f) != 1)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Writes incompressible bytes.
+ * @internal
+ */
+static int gen_random(FILE* f, uint64_t size) {
+
+	uint64_t	written, r;
+
+	for (written = 0; written < size; written += sizeof(r)) {
+		r = rng();
+		if (fwrite(&r, sizeof(r), 1, f) != 1)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Writes a few blocks of random bytes over and over, with rare mutations.
+ * @internal
+ */
+static int gen_repetitive(FILE* f, uint64_t size) {
+
+	uint8_t		*block[BLOCKS], *buf;
+	uint32_t	len[BLOCKS], i, j;
+	uint64_t	written = 0;
+
+	buf = malloc((size_t)BLOCKS * CORPUS_TINY_MAX);
+	if (buf == NULL)
+		return -1;
+	for (i = 0; i < BLOCKS; i++) {
+		block[i] = buf + i * CORPUS_TINY_MAX;
+		len[i] = 1024 + rng_below(CORPUS_TINY_MAX - 1024);
+		for (j = 0; j < len[i]; j++)
+			block[i][j] = rng();
+	}
+
+	while (written < size) {
+		i = rng_zipf(BLOCKS);
+		if (rng_below(4) == 0) // mutate one byte for good
+			block[i][rng_below(len[i])] = rng();
+		if (fwrite(block[i], 1, len[i], f) != len[i]) {
+			free(buf);
+			return -1;
+		}
+		written += len[i];
+	}
+
+	free(buf);
+	return 0;
+}
+
+/**
+ * Writes one small JSON event.
+ * @internal
+ */
+static int gen_event(FILE* f, uint32_t n) {
+
+	static const char *events[] = { "login", "logout", "purchase", "view", "click", "error" };
+	int		len, items;
+
+	len = fprintf(f, "{\"ts\": %u, \"event\": \"%s\", \"user\": \"user%u\", \"session\": \"%016llx\", \"items\": [",
+			1368500000 + 37 * n, events[rng_zipf(6)], rng_zipf(1000), (unsigned long long)rng());
+	items = rng_below((CORPUS_TINY_MAX - 160) / 60);
+	while (items-- > 0 && len >= 0)
+		len += fprintf(f, "{\"sku\": \"SKU-%05u\", \"qty\": %u, \"price\": %u.%02u}%s", rng_zipf(100000),
+				1 + rng_zipf(5), rng_below(100), rng_below(100), items > 0 ? ", " : "");
+	len += fprintf(f, "]}\n");
+
+	return len;
+}
+
+void corpus_path(char* path, int len, const char* dir, const char* name, int i, int count) {
+
+	if (count == 1)
+		snprintf(path, len, "%s/%s", dir, name);
+	else
+		snprintf(path, len, "%s/%s.%04d", dir, name, i);
+}
+
+int corpus_generate(const char* dir, const char* name, uint64_t size) {
+
+	char	path[4096];
+	FILE	*f;
+	int		n = 0, ret = 0;
+
+	rng_state = CORPUS_SEED;
+
+	if (strcmp(name, "tiny") == 0) { // one event per file, each one starts a new file
+		uint64_t written = 0;
+
+		for (n = 0; written < size || n < 2; n++) { // more than one, see corpus_path()
+			int len;
+
+			corpus_path(path, sizeof(path), dir, name, n, 0);
+			f = fopen(path, "w");
+			if (f == NULL)
+				return -1;
+			len = gen_event(f, n);
+			if (fclose(f) != 0 || len < 0)
+				return -1;
+			written += len;
+		}
+		return n;
+	}
+
+	corpus_path(path, sizeof(path), dir, name, 0, 1);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return -1;
+
+	if (strcmp(name, "text") == 0)
+		ret = gen_text(f, size);
+	else if (strcmp(name, "log") == 0)
+		ret = gen_log(f, size);
+	else if (strcmp(name, "binary") == 0)
+		ret = gen_binary(f, size);
+	else if (strcmp(name, "random") == 0)
+		ret = gen_random(f, size);
+	else if (strcmp(name, "repetitive") == 0)
+		ret = gen_repetitive(f, size);
+	else {
+		errno = EINVAL;
+		ret = -1;
+	}
+
+	if (fclose(f) != 0 || ret < 0) {
+		unlink(path);
+		return -1;
+	}
+	return 1;
+}
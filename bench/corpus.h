@@ -0,0 +1,54 @@
+/**
+ * @file	corpus.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for the generator of the benchmark corpora.
+ */
+
+#ifndef __CORPUS_H__
+#define __CORPUS_H__
+
+#include <stdint.h>
+
+#define CORPUS_SEED		0x4C5A3738	/**< Seed of every corpus: the same corpora are generated on every run. */
+#define CORPUS_TINY_MIN	100			/**< Minimum size of a file of the tiny corpus. */
+#define CORPUS_TINY_MAX	4096		/**< Maximum size of a file of the tiny corpus. */
+
+/**
+ * Names of the corpora, terminated by @c NULL:
+ * @c "text" (words of a Zipf distributed vocabulary), @c "log" (server log
+ * lines from a few templates), @c "binary" (fixed size records of slowly
+ * changing fields), @c "random" (incompressible bytes), @c "repetitive"
+ * (a few blocks repeated with rare mutations) and @c "tiny" (small JSON
+ * events, one per file).
+ */
+extern const char* const corpus_names[];
+
+/**
+ * Writes corpus @p name of about @p size bytes in directory @p dir.
+ * A corpus is a single file named @p name, except @c "tiny" whose files are
+ * named @p name followed by a dot and their number (see corpus_path()): it
+ * always has more than one file.
+ *
+ *	@param	dir		Directory where to write the corpus.
+ *	@param	name	Name of the corpus, one of corpus_names.
+ *	@param	size	Size of the corpus, in bytes.
+ *
+ *	@return	The number of files written on success, @c -1 on failure.
+ */
+int corpus_generate(const char* dir, const char* name, uint64_t size);
+
+/**
+ * Writes in @p path the name of the @p i-th file of corpus @p name in
+ * directory @p dir, made of @p count files.
+ *
+ *	@param	path	Buffer where to write the name.
+ *	@param	len		Size of @p path.
+ *	@param	dir		Directory of the corpus.
+ *	@param	name	Name of the corpus.
+ *	@param	i		Number of the file.
+ *	@param	count	Number of files of the corpus.
+ */
+void corpus_path(char* path, int len, const char* dir, const char* name, int i, int count);
+
+#endif
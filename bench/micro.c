@@ -0,0 +1,491 @@
+/**
+ * @file	micro.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Microbenchmarks of the dictionary and bitio primitives.
+ *
+ * Measures the time per operation of dict_lookup() (by load factor of the
+ * hash table and ratio of hits), dict_word() (by length of the word) and
+ * bitio_write()/bitio_read() and their batch versions bitio_write_codes()/
+ * bitio_read_codes() (by width of the values). The process is pinned
+ * to one core; every measure is repeated after a few warm-up batches, and
+ * the batches are summarized by their minimum, median, 90th percentile, mean
+ * and standard deviation.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bitio.h"
+#include "common.h"
+#include "dictionary.h"
+
+#define MAX_BATCHES		1000	/**< Maximum number of measured batches. */
+#define QUERIES			65536	/**< Lookups or words per batch. */
+#define WORD_NODES		65536	/**< Nodes of the words of each length. */
+#define BITIO_VALUES	1048576	/**< Values written or read per batch. */
+#define BITIO_CODES		1024	/**< Values passed to each bitio_write_codes() or bitio_read_codes() call. */
+#define MAX_RECORDS		8		/**< Maximum number of dictionary sizes of the lookup benchmark. */
+
+const char *help = "\
+Usage: lz78_micro [-b <benchmarks>] [-c <cpu>] [-n <records>] [-r <batches>] [-w <warmups>] [-f <tmp_file>] [-j <json_file>]\n\n\
+\
+  -b <benchmarks>  comma separated benchmarks: lookup, word, bitio (default all of them)\n\
+  -c <cpu>         core the process is pinned to (default the current one)\n\
+  -n <records>     comma separated records of the dictionaries of the lookup benchmark (default 1048576), up to 2^32 - 2\n\
+                   (e.g. 67108864,268435456,1073741824,2147483648 for large dictionaries, with enough memory)\n\
+  -r <batches>     measured batches of each measure (default 15)\n\
+  -w <warmups>     batches run before measuring (default 3)\n\
+  -f <tmp_file>    file written and read by the bitio benchmark (default /tmp/lz78_micro.dat)\n\
+  -j <json_file>   also write the results as JSON to <json_file>\n\n";
+
+/**
+ * Summary of the batches of a measure, in ns per operation.
+ */
+struct summary {
+	double	min;	/**< Fastest batch. */
+	double	p50;	/**< Median batch. */
+	double	p90;	/**< 90th percentile of the batches. */
+	double	mean;	/**< Mean of the batches. */
+	double	sd;		/**< Standard deviation of the batches. */
+};
+
+/**
+ * Function run by a measure: performs @p ops operations on @p arg.
+ */
+typedef void (*batch_fn)(void* arg, uint32_t ops);
+
+static int		batches = 15, warmups = 3, first_result = 1;
+static FILE		*json = NULL;
+
+/**
+ * Sink of the results of the measured operations, so that they are not
+ * optimized away.
+ */
+static volatile uint64_t sink;
+
+/**
+ * State of the xorshift64* generator.
+ */
+static uint64_t rng_state = 0x4C5A3738;
+
+static uint64_t rng(void) {
+
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static uint32_t rng_below(uint32_t n) {
+
+	return (rng() >> 32) * n >> 32;
+}
+
+static int cmp_double(const void* a, const void* b) {
+
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Runs @p fn with @p arg for the warm-up batches and the measured batches of
+ * @p ops operations, and prints the summary as measure @p name with
+ * parameters @p params (a JSON fragment).
+ */
+static void measure(const char* bench, const char* params, batch_fn fn, void* arg, uint32_t ops) {
+
+	struct timespec	t0, t1;
+	struct summary	s;
+	double			ns[MAX_BATCHES];
+	int				i;
+
+	for (i = 0; i < warmups; i++)
+		fn(arg, ops);
+
+	for (i = 0; i < batches; i++) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		fn(arg, ops);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ns[i] = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ops;
+	}
+
+	s.mean = 0;
+	for (i = 0; i < batches; i++)
+		s.mean += ns[i];
+	s.mean /= batches;
+	s.sd = 0;
+	for (i = 0; i < batches; i++)
+		s.sd += (ns[i] - s.mean) * (ns[i] - s.mean);
+	s.sd = batches > 1 ? sqrt(s.sd / (batches - 1)) : 0;
+
+	qsort(ns, batches, sizeof(*ns), cmp_double);
+	s.min = ns[0];
+	s.p50 = ns[(batches - 1) / 2];
+	s.p90 = ns[(batches * 9 + 9) / 10 - 1];
+
+	printf("%-8s %-36s %9.2f %9.2f %9.2f %9.2f %8.2f\n", bench, params, s.min, s.p50, s.p90, s.mean, s.sd);
+	fflush(stdout);
+
+	if (json != NULL) {
+		fprintf(json, "%s  {\"benchmark\": \"%s\", \"params\": \"%s\", \"ns_per_op\": {\"min\": %.3f, \"p50\": %.3f, "
+				"\"p90\": %.3f, \"mean\": %.3f, \"sd\": %.3f}}", first_result ? "" : ",\n", bench, params,
+				s.min, s.p50, s.p90, s.mean, s.sd);
+		first_result = 0;
+	}
+}
+
+/**
+ * Queries of the lookup benchmark.
+ */
+struct lookup_arg {
+	struct dictionary	*d;
+	uint32_t			*current;	/**< Node of each query. */
+	uint16_t			*symbol;	/**< Symbol of each query. */
+};
+
+static void lookup_batch(void* arg, uint32_t ops) {
+
+	struct lookup_arg	*a = arg;
+	uint32_t			i, y;
+	uint64_t			sum = 0;
+
+	for (i = 0; i < ops; i++)
+		sum += dict_lookup(a->d, a->current[i], a->symbol[i], &y) + y;
+	sink = sum;
+}
+
+/**
+ * Measures dict_lookup() on a dictionary of @p records random records (each
+ * one the child of a random node), for a few load factors of the hash table
+ * and ratios of hits. Load factors whose table would be larger than
+ * @c DICT_MAX_SIZE records are skipped.
+ */
+static int bench_lookup(uint32_t records) {
+
+	static const double	loads[] = { 0.25, 0.5, 0.75, 0.9 };
+	static const double	hits[] = { 0, 0.5, 1 };
+	struct lookup_arg	a;
+	uint32_t			*parent, *hit_current, *miss_current, first, ht_size, i, j, k, y;
+	uint16_t			*sym, *hit_symbol, *miss_symbol;
+	char				params[64];
+
+	parent = malloc(sizeof(*parent) * records);
+	sym = malloc(sizeof(*sym) * records);
+	hit_current = malloc(sizeof(*hit_current) * QUERIES);
+	hit_symbol = malloc(sizeof(*hit_symbol) * QUERIES);
+	miss_current = malloc(sizeof(*miss_current) * QUERIES);
+	miss_symbol = malloc(sizeof(*miss_symbol) * QUERIES);
+	a.current = malloc(sizeof(*a.current) * QUERIES);
+	a.symbol = malloc(sizeof(*a.symbol) * QUERIES);
+	if (parent == NULL || sym == NULL || hit_current == NULL || hit_symbol == NULL || miss_current == NULL
+			|| miss_symbol == NULL || a.current == NULL || a.symbol == NULL)
+		return -1;
+
+	for (i = 0; i < sizeof(loads) / sizeof(*loads); i++) {
+		first = NUM_SYMBOLS + 1;
+		if (first + records / loads[i] > DICT_MAX_SIZE)
+			continue;
+		ht_size = first + records / loads[i];
+
+		// a table that is as large as it can be from the start
+		a.d = dict_new(ht_size - 1, 1, ht_size, NUM_SYMBOLS);
+		if (a.d == NULL || dict_reserve(a.d, ht_size - 1) < 0)
+			return -1;
+		dict_init(a.d);
+
+		rng_state = 0x4C5A3738;
+		for (j = 0; j < records; j++) {
+			do { // a symbol or one of the records so far
+				k = rng_below(NUM_SYMBOLS + j);
+				parent[j] = k < NUM_SYMBOLS ? k : first + k - NUM_SYMBOLS;
+				sym[j] = rng_below(NUM_SYMBOLS);
+			} while (dict_lookup(a.d, parent[j], sym[j], &y) != 0);
+			dict_fill(a.d, y, parent[j], sym[j], first + j);
+		}
+
+		for (j = 0; j < QUERIES; j++) {
+			k = rng_below(records);
+			hit_current[j] = first + k;
+			while (dict_lookup(a.d, hit_current[j], hit_symbol[j] = rng_below(NUM_SYMBOLS), &y) == 1) ; // any miss
+			miss_current[j] = hit_current[j];
+			miss_symbol[j] = hit_symbol[j];
+			hit_current[j] = parent[k];
+			hit_symbol[j] = sym[k];
+		}
+
+		for (j = 0; j < sizeof(hits) / sizeof(*hits); j++) {
+			for (k = 0; k < QUERIES; k++) {
+				int hit = rng_below(1000) < hits[j] * 1000;
+				a.current[k] = hit ? hit_current[k] : miss_current[k];
+				a.symbol[k] = hit ? hit_symbol[k] : miss_symbol[k];
+			}
+			snprintf(params, sizeof(params), "n=%u load=%.2f hits=%.1f", records, loads[i], hits[j]);
+			measure("lookup", params, lookup_batch, &a, QUERIES);
+		}
+
+		dict_delete(a.d);
+	}
+
+	free(parent);
+	free(sym);
+	free(hit_current);
+	free(hit_symbol);
+	free(miss_current);
+	free(miss_symbol);
+	free(a.current);
+	free(a.symbol);
+	return 0;
+}
+
+/**
+ * Words of the word benchmark.
+ */
+struct word_arg {
+	struct dictionary	*d;
+	uint32_t			*tail;		/**< Last node of each word. */
+	uint32_t			count;		/**< Number of words. */
+};
+
+static void word_batch(void* arg, uint32_t ops) {
+
+	struct word_arg	*a = arg;
+	uint32_t		i, len;
+	uint64_t		sum = 0;
+
+	for (i = 0; i < ops; i++)
+		sum += (uintptr_t)dict_word(a->d, a->tail[i % a->count], &len) + len;
+	sink = sum;
+}
+
+/**
+ * Measures dict_word() on a decompression dictionary, by word length. The
+ * nodes of the words are interleaved, like the records of a real dictionary.
+ */
+static int bench_word(void) {
+
+	static const uint32_t	lengths[] = { 1, 4, 16, 64, 256, 1024 };
+	struct word_arg			a;
+	uint32_t				i, j, c, first = NUM_SYMBOLS + 1;
+	char					params[64];
+
+	for (i = 0; i < sizeof(lengths) / sizeof(*lengths); i++) {
+		a.count = WORD_NODES / lengths[i];
+		a.tail = malloc(sizeof(*a.tail) * a.count);
+		a.d = dict_new(first + WORD_NODES, 0, first + WORD_NODES, NUM_SYMBOLS);
+		if (a.tail == NULL || a.d == NULL)
+			return -1;
+		dict_init(a.d);
+
+		// node j of word c is record first + j * count + c
+		for (c = 0; c < a.count; c++) {
+			a.tail[c] = rng_below(NUM_SYMBOLS);
+			for (j = 0; j < lengths[i] - 1; j++) {
+				dict_fill(a.d, first + j * a.count + c, a.tail[c], rng_below(NUM_SYMBOLS), 0);
+				a.tail[c] = first + j * a.count + c;
+			}
+		}
+
+		snprintf(params, sizeof(params), "length=%u", lengths[i]);
+		measure("word", params, word_batch, &a, QUERIES);
+
+		dict_delete(a.d);
+		free(a.tail);
+	}
+
+	return 0;
+}
+
+/**
+ * Parameters of the bitio benchmark.
+ */
+struct bitio_arg {
+	const char	*name;		/**< File written and read. */
+	int			width;		/**< Width of the values, in bits. */
+	int			write;		/**< Indicates if the batch writes or reads. */
+	int			codes;		/**< Indicates if the values are written or read BITIO_CODES at a time. */
+	int			error;		/**< Set if a batch failed. */
+};
+
+static void bitio_batch(void* arg, uint32_t ops) {
+
+	struct bitio_arg	*a = arg;
+	struct bitio		*f;
+	uint64_t			v = 0, sum = 0, mask = a->width == 64 ? ~0ULL : (1ULL << a->width) - 1;
+	uint32_t			i, j, codes[BITIO_CODES];
+	int64_t				n;
+
+	f = bitio_open(a->name, a->write ? 'w' : 'r');
+	if (f == NULL) {
+		a->error = 1;
+		return;
+	}
+	for (i = 0; a->codes && i < ops; i += n) {
+		if (a->write) {
+			for (j = 0; j < BITIO_CODES; j++)
+				codes[j] = ((i + j) * 0x9E3779B97F4A7C15ULL) & mask;
+			n = bitio_write_codes(f, codes, ops - i < BITIO_CODES ? ops - i : BITIO_CODES, a->width);
+		}
+		else {
+			n = bitio_read_codes(f, codes, ops - i < BITIO_CODES ? ops - i : BITIO_CODES, a->width);
+			for (j = 0; j < n; j++)
+				sum += codes[j];
+		}
+		if (n <= 0) {
+			a->error = 1;
+			break;
+		}
+	}
+	for (i = 0; !a->codes && i < ops; i++) {
+		if (a->write) {
+			if (bitio_write(f, (i * 0x9E3779B97F4A7C15ULL) & mask, a->width) != a->width)
+				a->error = 1;
+		}
+		else {
+			if (bitio_read(f, &v, a->width) != a->width)
+				a->error = 1;
+			sum += v;
+		}
+	}
+	bitio_close(f);
+	sink = sum;
+}
+
+/**
+ * Measures bitio_write() and bitio_read() on file @p name, by width.
+ */
+static int bench_bitio(const char* name) {
+
+	static const int	widths[] = { 1, 8, 9, 12, 16, 20, 24, 32, 64 };
+	struct bitio_arg	a = { name, 0, 0, 0, 0 };
+	uint32_t			i;
+	char				params[64];
+
+	for (i = 0; i < sizeof(widths) / sizeof(*widths); i++) {
+		a.width = widths[i];
+		a.write = 1;
+		snprintf(params, sizeof(params), "write width=%d", widths[i]);
+		measure("bitio", params, bitio_batch, &a, BITIO_VALUES);
+		a.write = 0;
+		snprintf(params, sizeof(params), "read width=%d", widths[i]);
+		measure("bitio", params, bitio_batch, &a, BITIO_VALUES);
+		if (widths[i] <= 32) {
+			a.codes = 1;
+			a.write = 1;
+			snprintf(params, sizeof(params), "write_codes width=%d", widths[i]);
+			measure("bitio", params, bitio_batch, &a, BITIO_VALUES);
+			a.write = 0;
+			snprintf(params, sizeof(params), "read_codes width=%d", widths[i]);
+			measure("bitio", params, bitio_batch, &a, BITIO_VALUES);
+			a.codes = 0;
+		}
+		if (a.error)
+			return -1;
+	}
+
+	unlink(name);
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+	const char	*benchmarks = "lookup,word,bitio", *tmp_name = "/tmp/lz78_micro.dat", *json_name = NULL;
+	uint32_t	records[MAX_RECORDS] = { 1048576 };
+	int			c, i, n_records = 1, cpu = -1;
+	char		*tok;
+	cpu_set_t	set;
+
+	while ((c = getopt(argc, argv, "b:c:f:hj:n:r:w:")) != -1) {
+		switch (c) {
+			case 'b':
+				benchmarks = optarg;
+				break;
+			case 'c':
+				cpu = atoi(optarg);
+				break;
+			case 'f':
+				tmp_name = optarg;
+				break;
+			case 'j':
+				json_name = optarg;
+				break;
+			case 'n':
+				for (n_records = 0, tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+					if (n_records == MAX_RECORDS)
+						break;
+					records[n_records++] = strtoul(tok, NULL, 10);
+				}
+				break;
+			case 'r':
+				batches = atoi(optarg);
+				break;
+			case 'w':
+				warmups = atoi(optarg);
+				break;
+			case 'h':
+				printf("%s", help);
+				exit(EXIT_SUCCESS);
+			default:
+				fprintf(stderr, "%s", help);
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i = 0; i < n_records && records[i] != 0 && records[i] < DICT_MAX_SIZE - NUM_SYMBOLS; i++);
+	if (batches < 1 || batches > MAX_BATCHES || warmups < 0 || n_records == 0 || i < n_records) {
+		fprintf(stderr, "%s: Invalid arguments\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	// stay on one core: no migrations, and the same caches for every batch
+	if (cpu < 0)
+		cpu = sched_getcpu();
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) < 0)
+		perror("sched_setaffinity");
+
+	if (json_name != NULL) {
+		json = fopen(json_name, "w");
+		if (json == NULL) {
+			perror(json_name);
+			exit(EXIT_FAILURE);
+		}
+		fprintf(json, "{\"cpu\": %d, \"batches\": %d, \"warmups\": %d, \"records\": [", cpu, batches, warmups);
+		for (i = 0; i < n_records; i++)
+			fprintf(json, "%s%u", i > 0 ? ", " : "", records[i]);
+		fprintf(json, "], \"results\": [\n");
+	}
+
+	printf("Pinned to cpu %d, %d batches after %d warm-ups, ns per operation\n", cpu, batches, warmups);
+	printf("%-8s %-36s %9s %9s %9s %9s %8s\n", "bench", "params", "min", "p50", "p90", "mean", "sd");
+
+	for (i = 0; i < n_records && strstr(benchmarks, "lookup") != NULL; i++)
+		if (bench_lookup(records[i]) < 0) {
+			perror("lookup");
+			exit(EXIT_FAILURE);
+		}
+	if (strstr(benchmarks, "word") != NULL && bench_word() < 0) {
+		perror("word");
+		exit(EXIT_FAILURE);
+	}
+	if (strstr(benchmarks, "bitio") != NULL && bench_bitio(tmp_name) < 0) {
+		perror("bitio");
+		exit(EXIT_FAILURE);
+	}
+
+	if (json != NULL) {
+		fprintf(json, "\n]}\n");
+		fclose(json);
+	}
+
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file	autosize.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for automatic selection of the dictionary size.
+ */
+
+#ifndef __AUTOSIZE_H__
+#define __AUTOSIZE_H__
+
+#include <stdint.h>
+
+#define AUTO_RATIO		0	/**< Pick the dictionary size that gives the smallest output. */
+#define AUTO_SPEED		1	/**< Pick the fastest dictionary size among those with a good ratio. */
+#define AUTO_MEMORY		2	/**< Pick the smallest dictionary size among those with a good ratio. */
+#define AUTO_ERROR		-1	/**< Error code for autosize_objective(). */
+
+/**
+ * Parses the objective of an automatic dictionary size selection.
+ * @p str is the argument of the @c -s option: @c "auto" (same as
+ * @c "auto:ratio"), @c "auto:ratio", @c "auto:speed" or @c "auto:memory".
+ *
+ *	@param	str	String to be parsed.
+ *
+ *	@return	One of @c AUTO_RATIO, @c AUTO_SPEED and @c AUTO_MEMORY on success,
+ *			@c AUTO_ERROR if @p str is not a valid auto specification.
+ */
+int autosize_objective(const char* str);
+
+/**
+ * Selects the dictionary size for compressing file @p in_filename.
+ * A few slices of the input are compressed with candidate dictionary sizes
+ * (powers of two) without writing anything, and the best candidate for
+ * @p objective is returned. Inputs up to 1 MB are compressed entirely, so the
+ * choice is exact for them; for larger inputs it assumes that the sampled
+ * slices are representative of the whole file, and the sample grows as long
+ * as it does not fill the best candidate, up to the whole file or 16 MB.
+ * The trial compresses as compress() does with the default options (lzw
+ * growth, reset policy reset, codes at flat width).
+ * If the input is not a regular file (e.g. it is @c NULL, which means
+ * @c stdin) nothing can be sampled and @c 0 is returned.
+ *
+ *	@param	in_filename	Name of the file to be compressed.
+ *	@param	objective	One of @c AUTO_RATIO, @c AUTO_SPEED and @c AUTO_MEMORY.
+ *	@param	ht_size		If not @c 0, the hash table size to be used: candidates
+ *						cannot be larger than that. If @c 0, the hash table
+ *						size is derived from each candidate (see dict_ht_size()).
+ *
+ *	@return	The selected dictionary size on success, @c 0 on failure.
+ */
+uint32_t autosize_select(const char* in_filename, int objective, uint32_t ht_size);
+
+#endif
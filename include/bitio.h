@@ -8,6 +8,7 @@
 #ifndef __BITIO_H__
 #define	__BITIO_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 //bitio context
@@ -49,6 +50,85 @@ int bitio_write(struct bitio *f, uint64_t data, int len);
  */
 int bitio_read(struct bitio *f, uint64_t *data, int len);
 
+/**
+ * Writes @p len whole bytes from @p data to @p f, with a copy rather than
+ * bit by bit. The stream must be at a byte boundary, e.g. after metadata or
+ * after writes of multiples of 8 bits.
+ *
+ * 	@param	f		Pointer to #bitio context
+ * 	@param	data	Bytes to be written.
+ * 	@param	len		Number of bytes to be written.
+ *
+ * 	@return	@p len on success, @c -1 otherwise (also if @p f is not at a byte boundary).
+ */
+int64_t bitio_write_bytes(struct bitio *f, const void *data, size_t len);
+
+/**
+ * Reads at most @p len whole bytes from @p f to @p data, with a copy rather
+ * than bit by bit. The stream must be at a byte boundary.
+ *
+ * 	@param	f		Pointer to #bitio context
+ * 	@param	data	Pointer to destination area.
+ * 	@param	len		Number of bytes to be read.
+ *
+ * 	@return	Number of read bytes (less than @p len at the end of the file) on
+ * 			success, @c -1 otherwise (also if @p f is not at a byte boundary).
+ */
+int64_t bitio_read_bytes(struct bitio *f, void *data, size_t len);
+
+/**
+ * Writes the @p n codes of @p codes to @p f, @p bits bits each, as @p n
+ * bitio_write() calls would, but packing them a word at a time (with vector
+ * instructions if the CPU has them, see cpu_level()).
+ *
+ * 	@param	f		Pointer to #bitio context
+ * 	@param	codes	Codes to be written, below 2^@p bits.
+ * 	@param	n		Number of codes.
+ * 	@param	bits	Bits of each code, between 1 and 32.
+ *
+ * 	@return	@p n on success, @c -1 otherwise.
+ */
+int64_t bitio_write_codes(struct bitio *f, const uint32_t *codes, size_t n, int bits);
+
+/**
+ * Reads at most @p n codes of @p bits bits each from @p f to @p codes, as
+ * bitio_read() calls would. It stops before the end of the buffer, so that
+ * the codes can be given back with bitio_unread(): at least one code is read
+ * unless the file ends.
+ *
+ * 	@param	f		Pointer to #bitio context
+ * 	@param	codes	Pointer to destination area.
+ * 	@param	n		Maximum number of codes to be read.
+ * 	@param	bits	Bits of each code, between 1 and 32.
+ *
+ * 	@return	Number of read codes (@c 0 at the end of the file) on success,
+ * 			@c -1 otherwise.
+ */
+int64_t bitio_read_codes(struct bitio *f, uint32_t *codes, size_t n, int bits);
+
+/**
+ * Gives back the last @p len bits read from @p f, so that the next read
+ * starts from them. They must have been read by the last bitio_read_codes()
+ * call, or since it without reading past the buffer.
+ *
+ * 	@param	f		Pointer to #bitio context
+ * 	@param	len		Number of bits to be given back.
+ *
+ * 	@return	@c 0 on success, @c -1 otherwise (also if the bits are not in the buffer anymore).
+ */
+int bitio_unread(struct bitio *f, uint64_t len);
+
+/**
+ * Moves @p f to the next byte boundary, so that bitio_write_bytes() and
+ * bitio_read_bytes() can be used: the bits up to it are written as zeros,
+ * or skipped when reading.
+ *
+ * 	@param	f		Pointer to #bitio context
+ *
+ * 	@return	@c 0 on success, @c -1 otherwise.
+ */
+int bitio_align(struct bitio *f);
+
 /**
  * Flushes the buffer to the correspondent file descriptor.
  * 	@param	f		Pointer to #bitio context
@@ -69,4 +149,14 @@ int bitio_flush(struct bitio *f);
  */
 int bitio_close(struct bitio *f);
 
+/**
+ * Returns the number of bytes read from or written to the file of @p f so
+ * far: bits still in the buffer are not counted.
+ *
+ * 	@param	f	Pointer to #bitio context
+ *
+ *	@return	Number of bytes, @c 0 if @p f is @c NULL.
+ */
+uint64_t bitio_bytes(const struct bitio *f);
+
 #endif
@@ -8,6 +8,7 @@
 #ifndef __COMMON_H__
 #define __COMMON_H__
 
+#include <stdint.h>
 #include <stdio.h>
 
 #define NUM_SYMBOLS		256			/**< Number of symbols in the alphabet. */
@@ -18,8 +19,27 @@
 #define META_NAME		2	/**< Metadata field type flag for original filename. */
 #define META_TIMESTAMP	4	/**< Metadata field type flag for file creation timestamp. */
 #define META_MD5		8	/**< Metadata field type flag for md5 sum. */
+#define META_CTRL_CODES	16	/**< Metadata field type for the number of control codes reserved after EOF. */
+#define META_RESET_POLICY	17	/**< Metadata field type for the policy applied when the dictionary is full. */
+#define META_GROWTH		18	/**< Metadata field type for the way the dictionary grows. */
+#define META_ENTROPY	19	/**< Metadata field type for the entropy coder of the codes. */
+#define META_DICT_ID	20	/**< Metadata field type for the identifier of the dictionary file that primed the dictionary. */
+#define META_MAX_MEMORY	21	/**< Metadata field type for the memory budget the dictionary was sized for, in bytes. */
+#define META_HT_SIZE	22	/**< Metadata field type for the hash table size chosen for the memory budget. */
 #define META_ERROR		255	/**< Error code for meta_ functions. */
 
+#define RESET_POLICY_RESET		0	/**< Reset the dictionary as soon as it is full (default). */
+#define RESET_POLICY_FREEZE		1	/**< Keep using the full dictionary without adding records. */
+#define RESET_POLICY_ADAPTIVE	2	/**< Freeze the full dictionary, reset it when the ratio degrades. */
+#define RESET_POLICY_MANUAL		3	/**< Freeze the full dictionary, reset it only on request. */
+#define RESET_POLICY_RECYCLE	4	/**< Keep the most used half of the full dictionary, free the rest. */
+#define RESET_POLICY_ERROR		255	/**< Error code for reset_policy_parse(). */
+
+#define GROWTH_LZW				0	/**< Add the last phrase followed by the next symbol (default). */
+#define GROWTH_LZAP				1	/**< Add the previous phrase followed by every prefix of the last one. */
+#define GROWTH_LZMW				2	/**< Add the previous phrase followed by the last one. */
+#define GROWTH_ERROR			255	/**< Error code for growth_parse(). */
+
 /**
  * Computes the message digest of file @p fin, using the algorithm
  * specified by @p md_name, and returns a pointer to the computed digest.
@@ -68,4 +88,44 @@ char* sprinth(const unsigned char *buff, int size);
  */
 int path_len(const char* filename);
 
+/**
+ * Parses a dictionary reset policy specification: @c "reset", @c "freeze",
+ * @c "adaptive[:<threshold>]", @c "manual" or @c "recycle".
+ * For the adaptive policy @p threshold is set to the ratio degradation, in
+ * percent, that triggers a reset (default @c 10); it is left untouched otherwise.
+ *
+ *	@param	str			String to be parsed.
+ *	@param	threshold	Pointer to where to store the threshold.
+ *
+ *	@return	One of the @c RESET_POLICY_* values, @c RESET_POLICY_ERROR if @p str is invalid.
+ */
+uint8_t reset_policy_parse(const char *str, uint8_t *threshold);
+
+/**
+ * Returns the name of the dictionary reset policy @p policy.
+ *
+ *	@param	policy	One of the @c RESET_POLICY_* values.
+ *
+ *	@return	The name of the policy, @c "unknown" if @p policy is not valid.
+ */
+const char* reset_policy_name(uint8_t policy);
+
+/**
+ * Parses a dictionary growth specification: @c "lzw", @c "lzap" or @c "lzmw".
+ *
+ *	@param	str	String to be parsed.
+ *
+ *	@return	One of the @c GROWTH_* values, @c GROWTH_ERROR if @p str is invalid.
+ */
+uint8_t growth_parse(const char *str);
+
+/**
+ * Returns the name of the dictionary growth @p growth.
+ *
+ *	@param	growth	One of the @c GROWTH_* values.
+ *
+ *	@return	The name of the growth, @c "unknown" if @p growth is not valid.
+ */
+const char* growth_name(uint8_t growth);
+
 #endif
\ No newline at end of file
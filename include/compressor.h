@@ -10,6 +10,24 @@
 
 #include <stdint.h>
 
+#include "dictfile.h"
+
+/**
+ * Compression options that change the format of the compressed stream.
+ * Options not at their default value are stored as metadata, so that the
+ * decompressor does not need them.
+ */
+struct comp_options {
+	uint8_t		reset_policy;		/**< What to do when the dictionary is full, one of @c RESET_POLICY_*. */
+	uint8_t		reset_threshold;	/**< Ratio degradation (percent) that triggers a reset with @c RESET_POLICY_ADAPTIVE. */
+	uint8_t		growth;				/**< How the dictionary grows, one of @c GROWTH_*. */
+	uint8_t		entropy;			/**< How codes are written, one of @c ENTROPY_*. */
+	uint8_t		runs;				/**< Indicates if runs of a byte are coded with @c RUN_SYMBOL (lzw growth only). */
+	uint8_t		store;				/**< Indicates if incompressible blocks are stored with @c STORED_SYMBOL (lzw growth without @c ENTROPY_RANGE only). */
+	const struct dictfile	*dictfile;	/**< Trained dictionary that primes the dictionary, or @c NULL. */
+	uint64_t	max_memory;			/**< Memory budget (bytes) the dictionary and hash table sizes were chosen for, or @c 0. */
+};
+
 /**
  * Compress file @p in_filename using a dictionary of size @p dict_size and store
  * the output in file @p out_filename.
@@ -29,9 +47,17 @@
  *	@param	dict_size		Dictionary size in number of records.
  *	@param	ht_size			Hash table size in number of records.
  *	@param	flags			Indicates whether metadata should be written or not.
+ *	@param	opts			Stream format options; if @c NULL, defaults are used.
  *
  *	@return	The size of original file on success,  @c -1 on failure.
  */
-int64_t compress(const char* in_filename, const char* out_filename, uint32_t dict_size, uint32_t ht_size, uint8_t flags);
+int64_t compress(const char* in_filename, const char* out_filename, uint32_t dict_size, uint32_t ht_size, uint8_t flags, const struct comp_options* opts);
+
+/**
+ * Requests the running compress() to reset the dictionary at the next phrase
+ * boundary. It is ignored unless the policy is @c RESET_POLICY_ADAPTIVE or
+ * @c RESET_POLICY_MANUAL, and it is safe to call it from a signal handler.
+ */
+void compress_reset_request(void);
 
 #endif
@@ -0,0 +1,50 @@
+/**
+ * @file	cpu.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for the CPU features that select the vectorized kernels.
+ *
+ * The binary is built for the baseline of the architecture: kernels that
+ * use wider instructions are compiled for them with function attributes, and
+ * picked at run time by the level cpu_level() returns. Environment variable
+ * @c LZ78_SIMD sets the level to any one the CPU supports, so that every
+ * kernel can be tested on the same machine: @c generic, @c sse4.2, @c avx2
+ * or @c avx512.
+ */
+
+#ifndef __CPU_H__
+#define __CPU_H__
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_X86		1	/**< Defined if kernels for x86 vector extensions are built. */
+#endif
+
+#define CPU_GENERIC	0	/**< Plain C kernels. */
+#define CPU_SSE42	1	/**< SSE up to 4.2: 128-bit vectors. */
+#define CPU_AVX2	2	/**< AVX2: 256-bit vectors. */
+#define CPU_AVX512	3	/**< AVX-512 Foundation and Byte/Word: 512-bit vectors and mask registers. */
+#define CPU_LEVELS	4	/**< Number of levels. */
+
+/**
+ * Returns the level of vector instructions of the kernels: the one set by
+ * @c LZ78_SIMD if the CPU supports it, else the highest one the CPU supports
+ * up to @c CPU_AVX2 (with a warning on stderr if @c LZ78_SIMD names an
+ * unknown or unsupported level). It is detected on the first call (with @c cpuid, on
+ * x86), the following calls return the same level.
+ *
+ *	@return	One of the @c CPU_* values.
+ */
+uint8_t cpu_level(void);
+
+/**
+ * Returns the name of @p level, as @c LZ78_SIMD takes it.
+ *
+ *	@param	level	One of the @c CPU_* values.
+ *
+ *	@return	The name, "unknown" if @p level is not valid.
+ */
+const char* cpu_level_name(uint8_t level);
+
+#endif
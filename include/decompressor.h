@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 
+#include "dictfile.h"
+
 #define DEC_ORIG_FILENAME	1	/**< Flag for saving decompressed file with original filename*/
 
 /**
@@ -25,10 +27,15 @@
  *						if @c NULL, this function reads data from @c stdin.
  *	@param	fout		Output stream passed as @c FILE* pointer.
  *	@param	flags		Decompression options.
+ *	@param	df			Dictionary file the stream was compressed with, if any;
+ *						it may be @c NULL when the stream needs none.
+ *	@param	max_memory	Memory the decompression may take, in bytes, or @c 0 for no
+ *						limit: a stream that needs more (see memlimit_needed()) fails
+ *						with @c ENOMEM before the output is created.
  * .
  *
  *	@return	The size of the output file on success, @c -1 on failure.
  */
-int64_t decompress(const char* in_filename, const char* out_filename, uint8_t flags);
+int64_t decompress(const char* in_filename, const char* out_filename, uint8_t flags, const struct dictfile* df, uint64_t max_memory);
 
 #endif
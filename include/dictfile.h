@@ -0,0 +1,104 @@
+/**
+ * @file	dictfile.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for trained dictionary files, used to prime the dictionary.
+ */
+
+#ifndef __DICTFILE_H__
+#define __DICTFILE_H__
+
+#include <stdint.h>
+
+#include "dictionary.h"
+
+#define DICTFILE_RECORDS	16384	/**< Default number of records of a trained dictionary. */
+
+/**
+ * Trained dictionary file context.
+ * A dictionary file holds records learned from a sample of the data to be
+ * compressed: compressor and decompressor start from them instead of an
+ * empty dictionary, which makes a difference for small inputs.
+ * The file is made of a header, the parent of each record (32 bits) and the
+ * symbol of each record (8 bits), in host byte order: it is mapped in memory
+ * as it is, and the context is read-only once opened, so any number of
+ * threads can prime their dictionaries with it at the same time.
+ */
+struct dictfile;
+
+/**
+ * Builds a dictionary file of at most @p records records from the sample
+ * files @p in_filenames, and writes it to @p out_filename.
+ * The samples are compressed with a dictionary larger than @p records and
+ * the recycle policy; in the end the records with the most used subtrees are
+ * kept (see dict_recycle()). Each sample starts a new phrase.
+ *
+ *	@param	out_filename	Name of the dictionary file to be written.
+ *	@param	in_filenames	Names of the sample files.
+ *	@param	count			Number of sample files; if @c 0, @c stdin is the sample.
+ *	@param	records			Maximum number of records.
+ *
+ *	@return	The number of records written on success, @c -1 on failure.
+ */
+int64_t dictfile_train(const char* out_filename, char* const* in_filenames, int count, uint32_t records);
+
+/**
+ * Opens dictionary file @p filename: it is mapped read-only and checked,
+ * and its records are indexed for lookups.
+ *
+ *	@param	filename	Name of the dictionary file.
+ *
+ *	@return	Pointer to the new context on success, @c NULL on failure.
+ */
+struct dictfile* dictfile_open(const char* filename);
+
+/**
+ * Returns the identifier of dictionary file @p df, a hash of its records:
+ * it is stored in compressed streams, so that they are decompressed with the
+ * same dictionary file.
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+uint64_t dictfile_id(const struct dictfile* df);
+
+/**
+ * Returns the index of the first record of dictionary file @p df: the codes
+ * between the symbols and it are control codes.
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+uint32_t dictfile_first_record(const struct dictfile* df);
+
+/**
+ * Returns the number of records of dictionary file @p df.
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+uint32_t dictfile_records(const struct dictfile* df);
+
+/**
+ * Returns the read-only dictionary of the records of @p df, to be passed to
+ * dict_set_base(). It is valid until dictfile_close().
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+const struct dictionary* dictfile_dict(const struct dictfile* df);
+
+/**
+ * Returns the memory dictionary file @p df takes, in bytes: the mapped file
+ * and the read-only dictionary of its records. It is shared by all the
+ * dictionaries primed with it.
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+uint64_t dictfile_memory(const struct dictfile* df);
+
+/**
+ * Closes dictionary file @p df. No dictionary primed with it can be used
+ * afterwards.
+ *
+ *	@param	df	Pointer to the dictionary file context.
+ */
+void dictfile_close(struct dictfile* df);
+
+#endif
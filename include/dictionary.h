@@ -18,6 +18,10 @@
 #define EMPTY_NODE		DICT_MAX_SIZE		/**< Symbol code to indicate an empty record. */
 
 #define EOF_SYMBOL		NUM_SYMBOLS			/**< Symbol code for EndOfFile. */
+#define RESET_SYMBOL	(EOF_SYMBOL + 1)	/**< Control code that resets the dictionary. */
+#define RUN_SYMBOL		(EOF_SYMBOL + 2)	/**< Control code of a run of one byte, followed by the byte and its length. */
+#define STORED_SYMBOL	(EOF_SYMBOL + 3)	/**< Control code of bytes stored as they are, followed by their number. */
+#define CTRL_CODES		3					/**< Number of control codes after EOF_SYMBOL known by this version. */
 
 /**
  * Dictionary context structure.
@@ -33,9 +37,13 @@ int	 dict_isempty(const struct dictionary* d, uint32_t ht_index);
 
 /**
  * Allocate and initialize a new dictionary.
+ * A compression dictionary starts with a small hash table that is grown
+ * on demand (see dict_fill()) up to @p ht_size records. A decompression
+ * dictionary has no hash table: its records are indexed by node and packed in
+ * as few bits as @p size allows, e.g. 25 bits for 65536 records instead of 40.
  *	@param	size		Size of the new dictionary, in number of records.
  *	@param	compression Indicates if the dictionary will be used for compression.
- *	@param	ht_size		Size of the hash table, in number of records.
+ *	@param	ht_size		Maximum size of the hash table, in number of records.
  *	@param	symbols		Number of symbols in the alphabet.
  *
  *	@return	Pointer to the newly allocated dictionary on success, @c NULL on failure.
@@ -49,6 +57,60 @@ struct dictionary* dict_new(uint32_t size, int compression, uint32_t ht_size, ui
  */
 void dict_delete(struct dictionary* d);
 
+/**
+ * Returns a hash table size suitable for a dictionary of @p size records:
+ * the table is about 1.5 times the dictionary and (table size - @p symbols - 1)
+ * is a prime number.
+ *	@param	size		Size of the dictionary, in number of records.
+ *	@param	symbols		Number of symbols in the alphabet.
+ *
+ *	@return	The hash table size, in number of records.
+ */
+uint32_t dict_ht_size(uint32_t size, uint32_t symbols);
+
+/**
+ * Returns the memory the dictionary @p d holds now, in bytes: the hash table
+ * at its current size, the usage counters, the node slots and the buffer of
+ * dict_word(). The records of a base dictionary (see dict_set_base()) are
+ * not counted, they belong to the base.
+ *	@param	d	Pointer to the dictionary.
+ *
+ *	@return	The memory held by @p d on success, @c 0 on failure.
+ */
+uint64_t dict_memory_usage(const struct dictionary* d);
+
+/**
+ * Returns the most memory, in bytes, a dictionary created by dict_new() with
+ * the same arguments can ever hold, before allocating it: the hash table at
+ * its maximum size, the table it grows from (both are allocated while it
+ * grows), the usage counters and the scratch arrays of dict_recycle() if
+ * @p track_uses is set, the node slots of a growth other than @c GROWTH_LZW
+ * and the buffer of dict_word() for the longest possible word.
+ * A decompression dictionary with a growth other than @c GROWTH_LZW is
+ * estimated as the compression dictionary the decompressor builds for it.
+ *	@param	size		Size of the dictionary, in number of records.
+ *	@param	compression Indicates if the dictionary will be used for compression.
+ *	@param	ht_size		Maximum size of the hash table, in number of records.
+ *	@param	symbols		Number of symbols in the alphabet.
+ *	@param	growth		One of the @c GROWTH_* values.
+ *	@param	track_uses	Indicates if dict_track_uses() will be called.
+ *
+ *	@return	The peak memory of the dictionary on success, @c 0 on failure.
+ */
+uint64_t dict_memory_estimate(uint32_t size, int compression, uint32_t ht_size, uint32_t symbols, uint8_t growth, int track_uses);
+
+/**
+ * Grows the hash table of the compression dictionary @p d, if needed, so that
+ * it can hold @p records records without growing again.
+ * It is a hint: the table never grows beyond the size given to dict_new() and
+ * it is still grown on demand if the hint was too small.
+ *	@param	d		Pointer to the dictionary.
+ *	@param	records	Expected number of records.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int dict_reserve(struct dictionary* d, uint32_t records);
+
 /**
  * Initialize the dictionary @p d.
  *	@param	d	Pointer to the dictionary to be initialized.
@@ -71,7 +133,7 @@ uint16_t dict_reinit(struct dictionary* d);
  * found, its index is put in @p ht_index and @c 1 is returned.
  * If the node is not found, in @p ht_index is put the index of the free record
  * where it should be and @c 0 is returned.
- * On error, @c -1 is returned.
+ * On error, @c -1 is returned. @c EOF_SYMBOL is only searched from @c ROOT_NODE.
  *
  *	@param	d			Pointer to the dictionary.
  *	@param	current		Node from which search starts.
@@ -84,6 +146,8 @@ int dict_lookup(const struct dictionary* d, uint32_t current, uint16_t symbol, u
 
 /**
  * Fill the record at index @p index in the dictionary @p d.
+ * In a compression dictionary, filling a record may grow (and rehash) the hash
+ * table: indexes returned by previous dict_lookup() calls are invalidated.
  *	@param	d			Pointer to the dictionary.
  *	@param	ht_index	Index of the record to be filled up.
  *	@param	current		Current node index to be placed in the record. If this is
@@ -95,6 +159,38 @@ int dict_lookup(const struct dictionary* d, uint32_t current, uint16_t symbol, u
  */
 int dict_fill(struct dictionary* d, uint32_t ht_index, uint32_t current, uint8_t symbol, uint32_t next);
 
+/**
+ * Type of the kernels returned by dict_match_kernel(). Starting from node
+ * @p cur (@c ROOT_NODE for none), a kernel follows the symbols of @p in, of
+ * @p len bytes, as long as the dictionary has them: it does what
+ * dict_lookup() and dict_next() do for each symbol, without their checks.
+ *
+ *	@param	d			Pointer to the dictionary.
+ *	@param	cur			Pointer to the starting node, where the last node found is stored.
+ *	@param	in			Symbols to be followed.
+ *	@param	len			Number of symbols.
+ *	@param	ht_index	Where to store, if a symbol is not found, the index of
+ *						the empty record for it (as dict_lookup() would).
+ *
+ *	@return	The number of symbols followed: @p len if all of them were found,
+ *			otherwise the position in @p in of the symbol not found.
+ */
+typedef uint32_t (*dict_match_fn)(const struct dictionary* d, uint32_t* cur, const uint8_t* in, uint32_t len, uint32_t* ht_index);
+
+/**
+ * Returns the kernel that follows symbols in the compression dictionary
+ * @p d, specialized at compile time for its layout (with or without a base
+ * dictionary). The checks of dict_lookup() are done here, once per run: it
+ * must be called after dict_set_base(), and the kernel is valid as long as
+ * @p d is, also when its hash table grows.
+ *
+ *	@param	d	Pointer to the dictionary.
+ *
+ *	@return	The kernel on success, @c NULL if @p d is not a compression
+ *			dictionary with @c GROWTH_LZW growth.
+ */
+dict_match_fn dict_match_kernel(const struct dictionary* d);
+
 /**
  * Returns the next node index contained in the record at index @p i.
  * If an error occurs, @c ROOT_NODE as an invalid value of next is returned.
@@ -117,7 +213,8 @@ uint32_t dict_next(const struct dictionary* d, uint32_t ht_index);
  * Returns a pointer to the word contained in the dictionary @p d correspondent
  * to the node @p node_index in the tree.
  * On return @p len contains the length of the word found. A call to dict_word overwrites
- * word returned on previous calls.
+ * word returned on previous calls. The buffer of the word grows with the words,
+ * up to the number of nodes of the dictionary: a longer walk fails with @c EINVAL.
  *
  *	@param	d			Pointer to the dictionary.
  *	@param	node_index	Index of the node.
@@ -138,4 +235,123 @@ char* dict_word(struct dictionary* d, uint32_t node_index, uint32_t* len);
  */
 uint16_t dict_first_symbol(const struct dictionary* d, uint32_t node_index);
 
+/**
+ * Sets how compression dictionary @p d grows, see the @c GROWTH_* values.
+ * With a growth other than @c GROWTH_LZW phrases are added by dict_grow(),
+ * and dict_word() can be used on the dictionary: the decompressor builds
+ * the same dictionary as the compressor.
+ * @c GROWTH_LZMW needs intermediate nodes for the prefixes of its phrases,
+ * with indexes from the dictionary size on: the hash table is allowed to
+ * grow beyond its maximum size if they do not fit.
+ *
+ *	@param	d		Pointer to the dictionary.
+ *	@param	growth	One of the @c GROWTH_* values.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int dict_set_growth(struct dictionary* d, uint8_t growth);
+
+/**
+ * Adds to dictionary @p d the phrases made of the phrase at node @p prev
+ * followed by @p word, the phrase that came after it.
+ * With @c GROWTH_LZAP a record is added for every prefix of @p word, with
+ * @c GROWTH_LZMW only for the whole concatenation (its missing prefixes become
+ * intermediate nodes). Phrases that are already nodes get no new record.
+ * If the intermediate nodes are exhausted nothing is added and the size of
+ * the dictionary is returned, as if it was full.
+ *
+ *	@param	d			Pointer to the dictionary.
+ *	@param	prev		Index of the node of the previous phrase.
+ *	@param	word		Symbols of the last phrase.
+ *	@param	len			Length of @p word.
+ *	@param	next_record	Index of the first record that is not filled.
+ *
+ *	@return	The index of the next free record on success, @c 0 on failure.
+ */
+uint32_t dict_grow(struct dictionary* d, uint32_t prev, const uint8_t* word, uint32_t len, uint32_t next_record);
+
+/**
+ * Starts tracking how many times each record of dictionary @p d is used.
+ * Counters are needed by dict_recycle() and are increased by dict_use().
+ *	@param	d	Pointer to the dictionary.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int dict_track_uses(struct dictionary* d);
+
+/**
+ * Increases the usage counter of the record at node @p node_index, if usage
+ * of dictionary @p d is tracked. Counters saturate instead of wrapping around.
+ *
+ *	@param	d			Pointer to the dictionary.
+ *	@param	node_index	Index of the used node.
+ */
+void dict_use(struct dictionary* d, uint32_t node_index);
+
+/**
+ * Recycles the records of the full dictionary @p d instead of wiping them.
+ * The (at most) @p keep records with the most used subtrees are kept, and
+ * renumbered from @p first_record on in their original order; the other
+ * records are freed. A kept record always has its parent kept, and usage
+ * counters of kept records are halved.
+ * The outcome depends only on the records and on their usage counters, so
+ * compressor and decompressor make the same choices.
+ *
+ *	@param	d				Pointer to the dictionary.
+ *	@param	first_record	Index of the first record that can be recycled.
+ *	@param	next_record		Index of the first record that is not filled.
+ *	@param	keep			Maximum number of records to be kept.
+ *
+ *	@return	The index of the next free record on success, @c 0 on failure.
+ */
+uint32_t dict_recycle(struct dictionary* d, uint32_t first_record, uint32_t next_record, uint32_t keep);
+
+/**
+ * Puts in @p parent and @p symbol the parent and the symbol of the records of
+ * dictionary @p d from @p first_record to (@p next_record - 1), in order.
+ *
+ *	@param	d				Pointer to the dictionary.
+ *	@param	first_record	Index of the first record.
+ *	@param	next_record		Index of the first record that is not filled.
+ *	@param	parent			Array of (@p next_record - @p first_record) parents.
+ *	@param	symbol			Array of (@p next_record - @p first_record) symbols.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int dict_records(const struct dictionary* d, uint32_t first_record, uint32_t next_record, uint32_t* parent, uint8_t* symbol);
+
+/**
+ * Creates a read-only dictionary of @p records records, numbered from
+ * @p first_record on, with parents @p parent and symbols @p symbol.
+ * A record must come after its parent, which is either a symbol or a record.
+ * The arrays are not copied: they must not change, and must outlive the
+ * dictionary. It can be shared by any number of dictionaries (and threads),
+ * see dict_set_base(), and is deleted with dict_delete().
+ *
+ *	@param	symbols			Number of symbols in the alphabet.
+ *	@param	first_record	Index of the first record.
+ *	@param	records			Number of records.
+ *	@param	parent			Parent of each record.
+ *	@param	symbol			Symbol of each record.
+ *
+ *	@return	Pointer to the new dictionary on success, @c NULL on failure.
+ */
+struct dictionary* dict_new_base(uint32_t symbols, uint32_t first_record, uint32_t records, const uint32_t* parent, const uint8_t* symbol);
+
+/**
+ * Primes dictionary @p d with the records of @p base, created by
+ * dict_new_base(): they are found by dict_lookup() and dict_word() as if they
+ * were records of @p d, without being copied, and they survive
+ * dict_reinit() and dict_recycle() (which must start after them).
+ * It must be called after dict_set_growth(), and @p base must outlive @p d.
+ *
+ *	@param	d				Pointer to the dictionary.
+ *	@param	base			Pointer to the read-only dictionary.
+ *	@param	first_record	Index of the first record of @p d: it must be the
+ *							first record of @p base.
+ *
+ *	@return	The index of the first record after the base on success, @c 0 on failure.
+ */
+uint32_t dict_set_base(struct dictionary* d, const struct dictionary* base, uint32_t first_record);
+
 #endif
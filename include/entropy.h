@@ -0,0 +1,89 @@
+/**
+ * @file	entropy.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for entropy module, an adaptive range coder for dictionary codes.
+ */
+
+#ifndef __ENTROPY_H__
+#define __ENTROPY_H__
+
+#include <stdint.h>
+
+#include "bitio.h"
+
+#define ENTROPY_NONE	0	/**< Codes are written at a flat width (default). */
+#define ENTROPY_RANGE	1	/**< Codes are coded by the adaptive range coder of this module. */
+#define ENTROPY_BYTES	2	/**< Codes are written as whole little-endian bytes, see ENTROPY_BYTES_WIDTH(). */
+
+#define ENTROPY_BYTES_MAX_SIZE	(1 << 24)	/**< Largest dictionary whose codes can be written as whole bytes. */
+
+/**
+ * Bytes of each code of a dictionary of @p size records written with
+ * @c ENTROPY_BYTES: 2 up to 65536 records, 3 up to @c ENTROPY_BYTES_MAX_SIZE.
+ */
+#define ENTROPY_BYTES_WIDTH(size)	((size) <= (1 << 16) ? 2 : 3)
+
+/**
+ * Entropy coder context.
+ * A code that is a record is coded as its distance from the newest record:
+ * the number of significant bits of the distance (its bucket) is coded with
+ * an adaptive model, conditioned on the previous bucket, and the bits below
+ * the most significant one are written as they are. Codes below the first
+ * record (symbols and control codes) are coded with their own adaptive model.
+ */
+struct entropy;
+
+/**
+ * Creates an entropy coder context that writes to (@p encode set) or reads
+ * from @p f. A decoder reads the first bytes of the coded stream right away.
+ *
+ *	@param	f				Pointer to the bitio context of the stream.
+ *	@param	encode			Indicates if codes are written or read.
+ *	@param	first_record	Index of the first record of the dictionary.
+ *
+ *	@return	Pointer to the new context on success, @c NULL on failure.
+ */
+struct entropy* entropy_new(struct bitio* f, int encode, uint32_t first_record);
+
+/**
+ * Codes @p code, when codes from @c 0 to (@p n - 1) are valid.
+ * Compressor and decompressor must agree on @p n for every code.
+ *
+ *	@param	e		Pointer to the entropy coder context.
+ *	@param	code	Code to be written.
+ *	@param	n		Number of valid codes.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int entropy_put(struct entropy* e, uint32_t code, uint32_t n);
+
+/**
+ * Decodes a code written by entropy_put() with the same @p n.
+ *
+ *	@param	e		Pointer to the entropy coder context.
+ *	@param	n		Number of valid codes.
+ *	@param	code	Pointer to where to store the code.
+ *
+ *	@return	@c 0 on success, @c -1 on failure (also if the decoded code is not valid).
+ */
+int entropy_get(struct entropy* e, uint32_t n, uint32_t* code);
+
+/**
+ * Writes the last bytes of the coded stream: it must be called after the
+ * last entropy_put(), before flushing the bitio context.
+ *
+ *	@param	e	Pointer to the entropy coder context.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int entropy_flush(struct entropy* e);
+
+/**
+ * Deletes an entropy coder context. The bitio context is not closed.
+ *
+ *	@param	e	Pointer to the entropy coder context.
+ */
+void entropy_delete(struct entropy* e);
+
+#endif
@@ -14,6 +14,18 @@
 #define DICT_SIZE_FLAG		4
 #define TABLE_SIZE_FLAG		8
 #define	ORIG_FILENAME_FLAG	16
+#define AUTO_SIZE_FLAG		32
+#define RESET_POLICY_FLAG	64
+#define GROWTH_FLAG			128
+#define ENTROPY_FLAG		256
+#define TRAIN_FLAG			512
+#define DICT_FILE_FLAG		1024
+#define PHASES_FLAG			2048
+#define ESTIMATE_FLAG		4096
+#define MAX_MEMORY_FLAG		8192
+#define FAST_FLAG			16384
+#define SPARSE_FLAG			32768
+#define STORE_FLAG			65536
 
 #include <sys/time.h>
 
@@ -44,10 +56,29 @@ void print_infos(int flags, const char *in_file, const char *out_file,  uint32_t
  *	@param in_file	Name of the input file.
  *	@param out_file	Name of the output file.
  *	@param filesize	Size of the decompressed file.
- *	@param t1		Struct that contains the time before the beginning of the compression/decompression.
+ *	@param t1		Struct that contains the time before the beginning of the compression/decompression, from monotonic_time().
  */
 void print_stats(int flags, const char *in_file, const char *out_file, uint64_t filesize, struct timeval t1);
 
+/**
+ * Print the most memory a compression and the decompression of its output
+ * can take, without running them (see memlimit_needed()).
+ *	@param dict_size	Size of the dictionary.
+ *	@param ht_size		Size of the hash table.
+ *	@param growth		How the dictionary grows, one of the @c GROWTH_* values.
+ *	@param track_uses	Indicates if the usage of the records is tracked (reset policy recycle).
+ *	@param shared		Memory of the dictionary file, shared by compressor and decompressor (@c 0 if none).
+ */
+void print_memory_estimate(uint32_t dict_size, uint32_t ht_size, uint8_t growth, int track_uses, uint64_t shared);
+
+/**
+ * Returns the time of the monotonic clock, which is not affected by changes
+ * of the system time.
+ *
+ *	@return	Time elapsed since an unspecified starting point.
+ */
+struct timeval monotonic_time(void);
+
 /**
  * Returns difference between @p t2 and @p t1 timeval structures.
  *
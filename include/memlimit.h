@@ -0,0 +1,71 @@
+/**
+ * @file	memlimit.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for memory budgets: dictionary sizes that fit in a given amount of memory.
+ *
+ * A budget is the memory a whole run may take. The dictionaries are sized
+ * with dict_memory_estimate(), an upper bound, and the rest of the process
+ * is counted as @c MEMLIMIT_PROCESS bytes.
+ */
+
+#ifndef __MEMLIMIT_H__
+#define __MEMLIMIT_H__
+
+#include <stdint.h>
+
+#define MEMLIMIT_PROCESS	(4*1024*1024)	/**< Memory of the process besides the dictionaries: libraries, I/O buffers, entropy coder. */
+
+/**
+ * Returns the memory limit of the cgroup of the process, the lowest one of
+ * its cgroup and of the cgroups above it (cgroup v2 @c memory.max, or cgroup
+ * v1 @c memory.limit_in_bytes).
+ *
+ *	@return	The limit in bytes, @c 0 if there is none or it cannot be read.
+ */
+uint64_t memlimit_cgroup(void);
+
+/**
+ * Parses a memory size: a number of bytes, optionally followed by one of the
+ * suffixes @c K, @c M, @c G and @c T (powers of 1024, in either case, with
+ * an optional @c B or @c iB), e.g. @c 256M or @c 1.5GiB.
+ *
+ *	@param	str		String to be parsed.
+ *	@param	bytes	Where to store the size, in bytes.
+ *
+ *	@return	@c 0 on success, @c -1 if @p str is not a valid size.
+ */
+int memlimit_parse(const char* str, uint64_t* bytes);
+
+/**
+ * Returns the memory a run needs with a dictionary of @p dict_size records:
+ * the dictionary, the dictionary file if any, and the rest of the process.
+ *
+ *	@param	dict_size	Size of the dictionary, in number of records.
+ *	@param	ht_size		Maximum size of the hash table, in number of records (compression only).
+ *	@param	compression	Indicates if the run compresses.
+ *	@param	growth		How the dictionary grows, one of the @c GROWTH_* values.
+ *	@param	track_uses	Indicates if the usage of the records is tracked (reset policy recycle).
+ *	@param	shared		Memory of the dictionary file, see dictfile_memory() (@c 0 if none).
+ *
+ *	@return	The memory needed in bytes on success, @c 0 on failure.
+ */
+uint64_t memlimit_needed(uint32_t dict_size, uint32_t ht_size, int compression, uint8_t growth, int track_uses, uint64_t shared);
+
+/**
+ * Returns the largest dictionary that both the compressor and the
+ * decompressor can use within @p budget bytes, and puts in @p ht_size the
+ * size of its hash table (about 1.5 times the dictionary, see dict_ht_size()).
+ *
+ *	@param	budget		Memory the run may take, in bytes.
+ *	@param	growth		How the dictionary grows, one of the @c GROWTH_* values.
+ *	@param	track_uses	Indicates if the usage of the records is tracked (reset policy recycle).
+ *	@param	shared		Memory of the dictionary file, see dictfile_memory() (@c 0 if none).
+ *	@param	ht_size		Where to store the size of the hash table.
+ *
+ *	@return	The size of the dictionary, in number of records, @c 0 if not even
+ *			the smallest one fits.
+ */
+uint32_t memlimit_dict_size(uint64_t budget, uint8_t growth, int track_uses, uint64_t shared, uint32_t* ht_size);
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file	phases.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for the per-phase time and resource accounting of a run.
+ */
+
+#ifndef __PHASES_H__
+#define __PHASES_H__
+
+#include <stdio.h>
+
+#define PHASE_NONE		-1	/**< Outside of any phase: nothing is accounted. */
+#define PHASE_META		0	/**< Opening the files, reading or writing the metadata. */
+#define PHASE_DIGEST	1	/**< Computing the digest of the input (compressor) or checking it (decompressor). */
+#define PHASE_DICT		2	/**< Allocating and initializing the dictionary and the entropy coder. */
+#define PHASE_LOOP		3	/**< Main loop, resets excluded. */
+#define PHASE_RESET		4	/**< Resetting or recycling the dictionary. */
+#define PHASE_FLUSH		5	/**< Flushing the coded stream. */
+#define PHASE_CLOSE		6	/**< Freeing the run and closing the files. */
+#define PHASES			7	/**< Number of phases. */
+
+/**
+ * Starts accounting the phases. Until it is called phase_enter() does
+ * nothing, so that runs that do not report the phases pay nothing for them.
+ */
+void phase_enable(void);
+
+/**
+ * Ends the current phase, if any, and starts phase @p phase.
+ * The monotonic time, the CPU time and the resource usage (context
+ * switches, page faults, block I/O and read/write system calls) since the
+ * previous call are charged to the phase that ends.
+ *
+ *	@param	phase	One of the @c PHASE_* values.
+ */
+void phase_enter(int phase);
+
+/**
+ * Prints the usage of each phase entered so far on @p f, as a table or as a
+ * JSON object if @p json is set.
+ *
+ *	@param	f		Where to print the phases.
+ *	@param	json	Indicates if the phases are printed as JSON.
+ */
+void phase_print(FILE* f, int json);
+
+#endif
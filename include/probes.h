@@ -0,0 +1,56 @@
+/**
+ * @file	probes.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file that provides the static tracepoints of lz78.
+ *
+ * Where <sys/sdt.h> is available (systemtap-sdt-dev, systemtap-sdt-devel)
+ * every PROBE* macro is a USDT probe of provider @c lz78: a single nop in
+ * the code and a note in the executable, that perf, bpftrace and systemtap
+ * can attach to at run time, e.g.
+ * @code
+ * perf buildid-cache --add ./lz78 && perf list sdt_lz78:*
+ * bpftrace -e 'usdt:./lz78:lz78:dict_reset { printf("%d %llu %u\n", arg0, arg1, arg2); }'
+ * @endcode
+ * Elsewhere, or with @c NO_PROBES defined, the macros expand to nothing.
+ *
+ * Probes and arguments:
+ *	- @c dict_reset (mode, offset, next_record, bits): the dictionary is
+ *	  reset or recycled; mode is @c 0 in compress() and @c 1 in decompress(),
+ *	  offset is the position in the original data, next_record and bits are
+ *	  the ones before the reset.
+ *	- @c flush (fd, bytes, total): bitio_flush() writes @c bytes bytes on
+ *	  @c fd, @c total bytes written before them.
+ *	- @c block_start (mode, offset_in, offset_out) and @c block_end (mode,
+ *	  offset_in, offset_out): a block of the input (compression) or of the
+ *	  output (decompression) starts or ends, at those positions of the
+ *	  input and of the output.
+ *	- @c meta_read (type, size) and @c meta_write (type, size): a metadata
+ *	  field is read or written.
+ */
+
+#ifndef __PROBES_H__
+#define __PROBES_H__
+
+#if !defined(NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HAVE_PROBES
+#endif
+#endif
+
+#ifdef HAVE_PROBES
+
+#define PROBE2(name, a, b)			DTRACE_PROBE2(lz78, name, a, b)
+#define PROBE3(name, a, b, c)		DTRACE_PROBE3(lz78, name, a, b, c)
+#define PROBE4(name, a, b, c, d)	DTRACE_PROBE4(lz78, name, a, b, c, d)
+
+#else
+
+#define PROBE2(name, a, b)
+#define PROBE3(name, a, b, c)
+#define PROBE4(name, a, b, c, d)
+
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file	stats.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for the hot path statistics of dictionary and coder.
+ *
+ * The statistics are collected only in builds with @c STATS defined
+ * (make STATS=1): otherwise every @c STATS_* macro expands to nothing, and
+ * its arguments are not even evaluated.
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define STATS_PROBES	16	/**< Buckets of the probe length histogram, the last one counts longer probe sequences. */
+#define STATS_WIDTHS	65	/**< Buckets of the code width histogram (0 to 64 bits). */
+#define STATS_DEPTHS	65	/**< Buckets of the phrase length histogram, by number of significant bits. */
+
+#ifdef STATS
+
+/**
+ * Counters of a run.
+ */
+struct stats {
+	uint64_t	hot_hits;				/**< Lookups served by the hot record cache. */
+	uint64_t	hot_misses;				/**< Lookups that went on to the hash table. */
+	uint64_t	hits;					/**< Hash table probe sequences that found the key. */
+	uint64_t	misses;					/**< Hash table probe sequences that ended on an empty record. */
+	uint64_t	skipped;				/**< Records skipped by the probe sequences. */
+	uint64_t	probes[STATS_PROBES];	/**< Probe sequences by number of records skipped. */
+	uint64_t	resets;					/**< Dictionary resets and recycles. */
+	double		load_sum;				/**< Sum of the load factors at each reset. */
+	double		load_min;				/**< Lowest load factor at a reset. */
+	double		load_max;				/**< Highest load factor at a reset. */
+	uint64_t	widths[STATS_WIDTHS];	/**< Codes written or read by code width. */
+	uint64_t	phrases;				/**< Phrases coded. */
+	uint64_t	phrase_bytes;			/**< Bytes of the phrases coded. */
+	uint64_t	depths[STATS_DEPTHS];	/**< Phrases by number of significant bits of their length. */
+};
+
+extern struct stats stats_counters;
+
+/**
+ * Counts a hash table probe sequence that skipped @p skipped records and
+ * found the key (@p hit set) or an empty record.
+ */
+#define STATS_PROBE(hit, skipped) stats_probe(hit, skipped)
+
+/**
+ * Counts a lookup in the hot record cache, served by it if @p hit is set.
+ */
+#define STATS_HOT(hit) (stats_counters.hot_hits += (hit), stats_counters.hot_misses += !(hit))
+
+/**
+ * Counts a reset of a dictionary with @p filled records out of @p capacity.
+ */
+#define STATS_RESET(filled, capacity) stats_reset(filled, capacity)
+
+/**
+ * Counts a code of @p bits bits.
+ */
+#define STATS_CODE(bits) (stats_counters.widths[bits]++)
+
+/**
+ * Counts a phrase of @p len bytes.
+ */
+#define STATS_PHRASE(len) stats_phrase(len)
+
+/**
+ * Prints the statistics as JSON to the verbose stream if the verbose level
+ * is at least @p level.
+ */
+#define STATS_PRINT(level) do { if (VERBOSE_LEVEL >= (level)) stats_print(VERBOSE_STREAM); } while (0)
+
+/**
+ * Counts a reset of a dictionary with @p filled records out of @p capacity.
+ * Resets of empty dictionaries are not counted.
+ */
+void stats_reset(uint64_t filled, uint64_t capacity);
+
+/**
+ * Prints the statistics collected so far as a JSON object on @p f.
+ *
+ *	@param	f	Where to print the statistics.
+ */
+void stats_print(FILE* f);
+
+/**
+ * Counts a hash table probe sequence that skipped @p skipped records and
+ * found the key (@p hit set) or an empty record.
+ */
+static inline void stats_probe(int hit, uint32_t skipped) {
+
+	stats_counters.hits += hit;
+	stats_counters.misses += !hit;
+	stats_counters.skipped += skipped;
+	stats_counters.probes[skipped < STATS_PROBES - 1 ? skipped : STATS_PROBES - 1]++;
+}
+
+/**
+ * Counts a phrase of @p len bytes.
+ */
+static inline void stats_phrase(uint64_t len) {
+
+	stats_counters.phrases++;
+	stats_counters.phrase_bytes += len;
+	stats_counters.depths[len ? 64 - __builtin_clzll(len) : 0]++;
+}
+
+#else
+
+#define STATS_PROBE(hit, skipped)
+#define STATS_HOT(hit)
+#define STATS_RESET(filled, capacity)
+#define STATS_CODE(bits)
+#define STATS_PHRASE(len)
+#define STATS_PRINT(level)
+
+#endif
+
+#endif
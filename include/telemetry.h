@@ -0,0 +1,65 @@
+/**
+ * @file	telemetry.h
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Header file for telemetry module, machine readable progress records of a run.
+ *
+ * Each record is a JSON object on its own line, e.g.
+ * @code
+ * {"mode": "compress", "time": 2.001, "bytes_in": 73400320, "bytes_out": 19136512, "ratio": 3.836, "mbps": 35.102, "resets": 3, "eta": 4.210, "done": false}
+ * @endcode
+ * @c time is in seconds since the start of the run, @c mbps is the input
+ * throughput (MB/s) since the previous record and @c eta the seconds left
+ * at that throughput, @c null when the size of the input is not known.
+ * The last record of a run has @c done set.
+ */
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+
+#define TELEMETRY_INTERVAL	1000	/**< Default time between two records, in milliseconds. */
+
+/**
+ * Starts writing telemetry records to @p dest: a file descriptor number
+ * (e.g. @c "3", already open) or the name of a file, created or truncated.
+ *
+ *	@param	dest		File descriptor or name of the file.
+ *	@param	interval	Minimum time between two records, in milliseconds.
+ *
+ *	@return	@c 0 on success, @c -1 on failure.
+ */
+int telemetry_open(const char* dest, uint32_t interval);
+
+/**
+ * Starts a run of mode @p mode (@c "compress" or @c "decompress") that
+ * reads @p total bytes, @c 0 if unknown.
+ */
+void telemetry_start(const char* mode, uint64_t total);
+
+/**
+ * Writes a record if the interval has elapsed since the previous one.
+ * It is meant to be called at block boundaries: it costs a read of the clock.
+ *
+ *	@param	in		Bytes read so far.
+ *	@param	out		Bytes written so far.
+ *	@param	resets	Dictionary resets so far.
+ */
+void telemetry_update(uint64_t in, uint64_t out, uint32_t resets);
+
+/**
+ * Writes the last record of a run.
+ *
+ *	@param	in		Bytes read.
+ *	@param	out		Bytes written.
+ *	@param	resets	Dictionary resets.
+ */
+void telemetry_end(uint64_t in, uint64_t out, uint32_t resets);
+
+/**
+ * Stops writing telemetry records, closing the file opened by telemetry_open().
+ */
+void telemetry_close(void);
+
+#endif
@@ -0,0 +1,221 @@
+/**
+ * @file	autosize.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for automatic selection of the dictionary size.
+ * @internal
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "autosize.h"
+#include "common.h"
+#include "debug.h"
+#include "dictionary.h"
+#include "verbose.h"
+
+#define AUTO_MIN_BITS		10					/**< log2 of the smallest candidate dictionary size. */
+#define AUTO_MAX_BITS		24					/**< log2 of the largest candidate dictionary size. */
+#define AUTO_STEP_BITS		2					/**< Candidates grow by a factor 2^AUTO_STEP_BITS. */
+#define AUTO_SLICES			4					/**< Number of slices sampled from large inputs. */
+#define AUTO_MIN_SAMPLE		(1024*1024)			/**< Inputs up to this size are sampled entirely. */
+#define AUTO_MAX_SAMPLE		(16*1024*1024)		/**< Maximum number of sampled bytes. */
+#define AUTO_GROW_SAMPLE	4					/**< Factor of the sample growth when it did not fill the best dictionary. */
+#define AUTO_MEMORY_SLACK	2					/**< Output growth (percent) accepted by AUTO_MEMORY. */
+#define AUTO_SPEED_SLACK	5					/**< Output growth (percent) accepted by AUTO_SPEED. */
+
+/**
+ * Compresses @p len bytes from @p buf with dictionary @p d, without writing
+ * anything, and returns the number of bits that compress() would produce
+ * with the default options. On return @p resets contains how many times the
+ * dictionary got full.
+ *
+ *	@return	Number of output bits on success, @c 0 on failure.
+ *	@internal
+ */
+static uint64_t autosize_trial(struct dictionary* d, uint32_t dict_size, const uint8_t* buf, size_t len, uint32_t* resets) {
+
+	size_t		i;
+	uint8_t		bits, initial_bits;
+	uint32_t	bitMask, cur, next_record, y;
+	uint64_t	out = 0;
+
+	next_record = dict_init(d);
+	if (next_record == 0)
+		return 0;
+
+	initial_bits = 0;
+	bitMask = 1;
+	while (bitMask < next_record) {
+		bitMask <<= 1;
+		initial_bits++;
+	}
+	bits = initial_bits;
+	bitMask = 1 << bits;
+
+	cur = ROOT_NODE;
+	for (i = 0; i < len; i++) {
+		if (!dict_lookup(d, cur, buf[i], &y)) {
+			out += bits;
+
+			if (!dict_fill(d, y, cur, buf[i], next_record++))
+				return 0;
+			if (next_record & bitMask) {
+				bitMask <<= 1;
+				bits++;
+			}
+
+			if (next_record == dict_size) {
+				next_record = dict_reinit(d);
+				bits = initial_bits;
+				bitMask = 1 << bits;
+				(*resets)++;
+			}
+
+			dict_lookup(d, ROOT_NODE, buf[i], &y);
+		}
+		cur = dict_next(d, y);
+	}
+
+	return out + 2*bits; // last word and EOF
+}
+
+int autosize_objective(const char* str) {
+
+	if (str == NULL || strncmp(str, "auto", 4) != 0)
+		return AUTO_ERROR;
+
+	str += 4;
+	if (*str == '\0' || strcmp(str, ":ratio") == 0)
+		return AUTO_RATIO;
+	if (strcmp(str, ":speed") == 0)
+		return AUTO_SPEED;
+	if (strcmp(str, ":memory") == 0)
+		return AUTO_MEMORY;
+
+	return AUTO_ERROR;
+}
+
+uint32_t autosize_select(const char* in_filename, int objective, uint32_t ht_size) {
+
+	FILE				*fin = NULL;
+	struct stat			file_stat;
+	struct dictionary	*d;
+	struct timespec		t1, t2;
+	uint8_t				*buf = NULL;
+	int					i, n, slices, best, chosen;
+	uint32_t			resets[AUTO_MAX_BITS + 1], candidate[AUTO_MAX_BITS + 1];
+	uint64_t			sample, slice_len, bits[AUTO_MAX_BITS + 1];
+	double				time[AUTO_MAX_BITS + 1];
+
+	if (in_filename == NULL)
+		return 0;
+
+	fin = fopen(in_filename, "r");
+	if (fin == NULL || fstat(fileno(fin), &file_stat) < 0 || !S_ISREG(file_stat.st_mode))
+		goto error;
+
+	sample = file_stat.st_size;
+	if (sample > AUTO_MIN_SAMPLE) {
+		sample /= 16;
+		if (sample < AUTO_MIN_SAMPLE)
+			sample = AUTO_MIN_SAMPLE;
+		if (sample > AUTO_MAX_SAMPLE)
+			sample = AUTO_MAX_SAMPLE;
+	}
+
+	// a dictionary that the sample does not fill may fill on the whole input,
+	// where it costs more than the sample shows: the sample grows until it
+	// fills the best dictionary or it is the whole input (or AUTO_MAX_SAMPLE)
+	for (;;) {
+		slices = sample < (uint64_t)file_stat.st_size ? AUTO_SLICES : 1;
+		slice_len = sample / slices;
+
+		// read the sampled slices
+		free(buf);
+		buf = malloc(sample + 1);
+		if (buf == NULL)
+			goto error;
+
+		for (i = 0; i < slices; i++) {
+			off_t ofs = slices == 1 ? 0 : i * ((file_stat.st_size - slice_len) / (slices - 1));
+			if (fseeko(fin, ofs, SEEK_SET) < 0 || fread(buf + i*slice_len, 1, slice_len, fin) != slice_len)
+				goto error;
+		}
+		PRINT(2, "Auto size sample:\t%llu bytes in %d slices\n", (unsigned long long)(slices * slice_len), slices);
+
+		// trial-compress the slices as one stream with growing candidates, until
+		// the dictionary never gets full
+		for (i = AUTO_MIN_BITS, n = 0, best = 0; i <= AUTO_MAX_BITS; i += AUTO_STEP_BITS) {
+			uint32_t size = (uint32_t)1 << i;
+
+			if (ht_size != 0 && size >= ht_size)
+				break;
+
+			d = dict_new(size, 1, ht_size != 0 ? ht_size : dict_ht_size(size, NUM_SYMBOLS), NUM_SYMBOLS);
+			if (d == NULL)
+				goto error;
+
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			resets[n] = 0;
+			bits[n] = autosize_trial(d, size, buf, slices * slice_len, &resets[n]);
+			clock_gettime(CLOCK_MONOTONIC, &t2);
+			dict_delete(d);
+			if (bits[n] == 0)
+				goto error;
+
+			candidate[n] = size;
+			time[n] = (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1e9;
+			PRINT(2, "Auto size %u:\t%.0f bytes in %.3f s\n", size, bits[n] / 8.0, time[n]);
+
+			if (bits[n] < bits[best])
+				best = n;
+			n++;
+
+			if (resets[n - 1] == 0) // a larger dictionary would give the same output
+				break;
+		}
+
+		if (n == 0) {
+			errno = EINVAL;
+			goto error;
+		}
+
+		if (resets[best] != 0 || sample >= (uint64_t)file_stat.st_size || sample >= AUTO_MAX_SAMPLE)
+			break;
+
+		sample *= AUTO_GROW_SAMPLE;
+		if (sample > (uint64_t)file_stat.st_size)
+			sample = file_stat.st_size;
+		if (sample > AUTO_MAX_SAMPLE)
+			sample = AUTO_MAX_SAMPLE;
+	}
+
+	// only measured candidates are chosen
+	chosen = best;
+	for (i = 0; i < n; i++) {
+		if (objective == AUTO_MEMORY && bits[i] * 100 <= bits[best] * (100 + AUTO_MEMORY_SLACK)) {
+			chosen = i;
+			break;
+		}
+		if (objective == AUTO_SPEED && bits[i] * 100 <= bits[best] * (100 + AUTO_SPEED_SLACK) && time[i] < time[chosen])
+			chosen = i;
+	}
+
+	LOG("Sampled %lu bytes in %d slices, chosen dictionary size %u", (unsigned long)(slices * slice_len), slices, candidate[chosen]);
+
+	free(buf);
+	fclose(fin);
+	return candidate[chosen];
+
+error:
+	free(buf);
+	if (fin != NULL)
+		fclose(fin);
+	return 0;
+}
@@ -16,7 +16,13 @@
 #include <unistd.h>
 
 #include "bitio.h"
+#include "cpu.h"
 #include "debug.h"
+#include "probes.h"
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
 
 #define BITIO_BUFF_SIZE 8*1024 //64 kB /**< @internal Buffer size for each bit I/O stream. */
 
@@ -43,6 +49,7 @@ struct bitio {
 	int			reading;				/**< Whether the file is open in reading mode (@c 1) or not (@c 0). */
 	int			next;					/**< Next bit to be written. */
 	int			end;					/**< Last bit of available data (reading) or last available bit space (writing). */
+	uint64_t	bytes;					/**< Bytes read from or written to the file descriptor so far. */
 	uint64_t 	buf[BITIO_BUFF_SIZE];	/**< Buffer for bits. */
 };
 
@@ -54,6 +61,7 @@ struct bitio* bstdin = &((struct bitio) {
 	.reading = 1,
 	.next = 0,
 	.end = 0,
+	.bytes = 0,
 	.buf = {}
 });
 
@@ -65,6 +73,7 @@ struct bitio* bstdout = &((struct bitio) {
 	.reading = 0,
 	.next = 0,
 	.end = sizeof(bstdout->buf)*8,
+	.bytes = 0,
 	.buf = {}
 });
 
@@ -76,6 +85,7 @@ struct bitio* bstderr = &((struct bitio) {
 	.reading = 0,
 	.next = 0,
 	.end = sizeof(bstderr->buf)*8,
+	.bytes = 0,
 	.buf = {}
 });
 
@@ -115,8 +125,10 @@ int bitio_flush(struct bitio *f) {
 
 	if (f != NULL && (!f->reading) && f->next != 0) { // there are bits in the buffer
 		int wbytes = (f->next+7) / 8; // (f->next+7)/8 == ceil(next/8)
+		PROBE3(flush, f->fd, wbytes, f->bytes);
 		if (write(f->fd, f->buf, wbytes) != wbytes)
 			return -1;
+		f->bytes += wbytes;
 		memset(f->buf, 0, sizeof(f->buf));
 		f->next = 0;
 	}
@@ -203,6 +215,7 @@ int bitio_read(struct bitio *f, uint64_t *data, int len) {
 				return -1;
 			if (f->end == 0)
 				return ret;
+			f->bytes += f->end / 8;
 			f->next = 0;
 		}
 
@@ -211,6 +224,8 @@ int bitio_read(struct bitio *f, uint64_t *data, int len) {
 		n = wsize - ofs; // number of bit that can be read in current word
 		if (n > len)
 			n = len;
+		if (n > f->end - f->next) // a short read may end the data within the word
+			n = f->end - f->next;
 
 		tmp = le64toh(*p);
 		tmp >>= ofs;
@@ -226,3 +241,350 @@ int bitio_read(struct bitio *f, uint64_t *data, int len) {
 
 	return ret;
 }
+
+int64_t bitio_write_bytes(struct bitio *f, const void *data, size_t len) {
+
+	const uint8_t	*src = data;
+	size_t			n, done = 0;
+
+	if (f == NULL || f->reading || f->next % 8 != 0 || data == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// the buffer holds the bytes of the file in order: whole bytes are copied
+	while (done < len) {
+		n = (f->end - f->next) / 8;
+		if (n > len - done)
+			n = len - done;
+		memcpy((uint8_t*)f->buf + f->next / 8, src + done, n);
+		f->next += 8 * n;
+		done += n;
+
+		if (f->next == f->end)
+			if (bitio_flush(f) < 0)
+				return -1;
+	}
+
+	return done;
+}
+
+int64_t bitio_read_bytes(struct bitio *f, void *data, size_t len) {
+
+	uint8_t		*dst = data;
+	size_t		n, done = 0;
+
+	if (f == NULL || !f->reading || f->next % 8 != 0 || data == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	while (done < len) {
+		if (f->next >= f->end) { // buffer is empty
+			f->end = 8*read(f->fd, f->buf, sizeof(f->buf));
+			if (f->end < 0)
+				return -1;
+			if (f->end == 0)
+				break;
+			f->bytes += f->end / 8;
+			f->next = 0;
+		}
+
+		n = (f->end - f->next) / 8;
+		if (n > len - done)
+			n = len - done;
+		memcpy(dst + done, (uint8_t*)f->buf + f->next / 8, n);
+		f->next += 8 * n;
+		done += n;
+	}
+
+	return done;
+}
+
+/**
+ * Bits of a buffer being filled a word at a time: the word being filled is
+ * kept in acc, words before it are stored.
+ * @internal
+ */
+struct packer {
+	uint64_t	*w;		/**< Word being filled. */
+	uint64_t	acc;	/**< Bits of the word filled so far. */
+	int			fill;	/**< Number of bits filled in acc. */
+};
+
+/**
+ * Starts filling @p buf from bit @p next, keeping the bits before it.
+ * @internal
+ */
+static inline void packer_start(struct packer* p, uint64_t* buf, uint32_t next) {
+
+	p->w = buf + next / 64;
+	p->fill = next % 64;
+	p->acc = p->fill != 0 ? le64toh(*p->w) & (((uint64_t)1 << p->fill) - 1) : 0;
+}
+
+/**
+ * Appends the @p width low bits of @p v, at most 64, to @p p.
+ * @internal
+ */
+static inline void packer_put(struct packer* p, uint64_t v, int width) {
+
+	p->acc |= v << p->fill;
+	p->fill += width;
+	if (p->fill >= 64) {
+		*p->w++ = htole64(p->acc);
+		p->fill -= 64;
+		p->acc = p->fill != 0 ? v >> (width - p->fill) : 0;
+	}
+}
+
+/**
+ * Stores the word being filled, its bits past the last one are zeroed.
+ * @internal
+ */
+static inline void packer_end(struct packer* p) {
+
+	if (p->fill != 0)
+		*p->w = htole64(p->acc);
+}
+
+/**
+ * Type of the kernels that pack @p n codes of @p bits bits from bit @p next
+ * of @p buf, which has room for them.
+ * @internal
+ */
+typedef void (*pack_fn)(uint64_t* buf, uint32_t next, const uint32_t* codes, size_t n, int bits);
+
+/**
+ * Type of the kernels that unpack @p n codes of @p bits bits from bit
+ * @p next of @p buf, which has 8 bytes readable from the first byte of each.
+ * @internal
+ */
+typedef void (*unpack_fn)(const uint64_t* buf, uint32_t next, uint32_t* codes, size_t n, int bits);
+
+/**
+ * Packs one code at a time.
+ * @internal
+ */
+static void pack_generic(uint64_t* buf, uint32_t next, const uint32_t* codes, size_t n, int bits) {
+
+	struct packer	p;
+	size_t			i;
+
+	packer_start(&p, buf, next);
+	for (i = 0; i < n; i++)
+		packer_put(&p, codes[i], bits);
+	packer_end(&p);
+}
+
+/**
+ * Unpacks one code at a time, each with an unaligned 8-byte load.
+ * @internal
+ */
+static void unpack_generic(const uint64_t* buf, uint32_t next, uint32_t* codes, size_t n, int bits) {
+
+	const uint8_t	*src = (const uint8_t*)buf;
+	uint64_t		v, pos = next, mask = ((uint64_t)1 << bits) - 1;
+	size_t			i;
+
+	for (i = 0; i < n; i++, pos += bits) {
+		memcpy(&v, src + pos / 8, sizeof(v));
+		codes[i] = (le64toh(v) >> (pos % 8)) & mask;
+	}
+}
+
+#ifdef CPU_X86
+/**
+ * Packs 8 codes at a time: pairs of codes are joined in 64-bit lanes with
+ * shifts, so that half as many values are appended to the buffer.
+ * @internal
+ */
+static __attribute__((target("avx2"))) void pack_avx2(uint64_t* buf, uint32_t next, const uint32_t* codes, size_t n, int bits) {
+
+	const __m256i	low = _mm256_set1_epi64x(0xFFFFFFFF);
+	const __m128i	shift = _mm_cvtsi32_si128(bits);
+	struct packer	p;
+	uint64_t		pair[4];
+	__m256i			v;
+	size_t			i = 0;
+
+	packer_start(&p, buf, next);
+	for (; i + 8 <= n; i += 8) {
+		v = _mm256_loadu_si256((const __m256i*)(codes + i)); // lanes of codes (2k + 1, 2k)
+		v = _mm256_or_si256(_mm256_and_si256(v, low), _mm256_sll_epi64(_mm256_srli_epi64(v, 32), shift));
+		_mm256_storeu_si256((__m256i*)pair, v);
+		packer_put(&p, pair[0], 2 * bits);
+		packer_put(&p, pair[1], 2 * bits);
+		packer_put(&p, pair[2], 2 * bits);
+		packer_put(&p, pair[3], 2 * bits);
+	}
+	for (; i < n; i++)
+		packer_put(&p, codes[i], bits);
+	packer_end(&p);
+}
+
+/**
+ * Unpacks 4 codes at a time: their 8 bytes are gathered from the byte of
+ * their first bit, and shifted each by its own offset.
+ * @internal
+ */
+static __attribute__((target("avx2"))) void unpack_avx2(const uint64_t* buf, uint32_t next, uint32_t* codes, size_t n, int bits) {
+
+	const __m256i	step = _mm256_set1_epi64x(4 * (uint64_t)bits), mask = _mm256_set1_epi64x(((uint64_t)1 << bits) - 1);
+	const __m256i	narrow = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	__m256i			pos = _mm256_add_epi64(_mm256_set1_epi64x(next), _mm256_setr_epi64x(0, bits, 2 * bits, 3 * bits)), v;
+	size_t			i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		v = _mm256_i64gather_epi64((const long long*)buf, _mm256_srli_epi64(pos, 3), 1);
+		v = _mm256_and_si256(_mm256_srlv_epi64(v, _mm256_and_si256(pos, _mm256_set1_epi64x(7))), mask);
+		_mm_storeu_si128((__m128i*)(codes + i), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, narrow)));
+		pos = _mm256_add_epi64(pos, step);
+	}
+	if (i < n)
+		unpack_generic(buf, next + i * bits, codes + i, n - i, bits);
+}
+#endif
+
+/**
+ * Pack kernels by CPU level.
+ * @internal
+ */
+static const pack_fn packs[CPU_LEVELS] = {
+	pack_generic,
+	pack_generic,
+#ifdef CPU_X86
+	pack_avx2,
+	pack_avx2,
+#else
+	pack_generic,
+	pack_generic,
+#endif
+};
+
+/**
+ * Unpack kernels by CPU level.
+ * @internal
+ */
+static const unpack_fn unpacks[CPU_LEVELS] = {
+	unpack_generic,
+	unpack_generic,
+#ifdef CPU_X86
+	unpack_avx2,
+	unpack_avx2,
+#else
+	unpack_generic,
+	unpack_generic,
+#endif
+};
+
+int64_t bitio_write_codes(struct bitio *f, const uint32_t *codes, size_t n, int bits) {
+
+	size_t	k, done = 0;
+
+	if (f == NULL || f->reading || codes == NULL || bits < 1 || bits > 32) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	while (done < n) {
+		k = (f->end - f->next) / bits; // codes that fit in the buffer
+		if (k == 0) { // the code crosses the end of the buffer
+			if (bitio_write(f, codes[done], bits) != bits)
+				return -1;
+			done++;
+			continue;
+		}
+		if (k > n - done)
+			k = n - done;
+
+		packs[cpu_level()](f->buf, f->next, codes + done, k, bits);
+		f->next += k * bits;
+		done += k;
+
+		if (f->next == f->end)
+			if (bitio_flush(f) < 0)
+				return -1;
+	}
+
+	return done;
+}
+
+int64_t bitio_read_codes(struct bitio *f, uint32_t *codes, size_t n, int bits) {
+
+	int			last = 8 * (sizeof(f->buf) - sizeof(uint64_t)); // last bit a code can start from with an 8-byte load
+	uint64_t	v;
+	size_t		k;
+
+	if (f == NULL || !f->reading || codes == NULL || bits < 1 || bits > 32) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (n == 0)
+		return 0;
+
+	if (f->next == f->end) { // buffer is empty
+		f->end = 8*read(f->fd, f->buf, sizeof(f->buf));
+		if (f->end < 0)
+			return -1;
+		if (f->end == 0)
+			return 0;
+		f->bytes += f->end / 8;
+		f->next = 0;
+	}
+
+	// whole codes in the buffer, that can be loaded with 8 bytes
+	k = (f->end - f->next) / bits;
+	if (f->next > last)
+		k = 0;
+	else if (k > (size_t)(last - f->next) / bits + 1)
+		k = (last - f->next) / bits + 1;
+	if (k > n)
+		k = n;
+
+	if (k == 0) { // the code crosses the end of the buffer
+		if (bitio_read(f, &v, bits) < bits)
+			return 0;
+		codes[0] = v;
+		return 1;
+	}
+
+	unpacks[cpu_level()](f->buf, f->next, codes, k, bits);
+	f->next += k * bits;
+
+	return k;
+}
+
+int bitio_unread(struct bitio *f, uint64_t len) {
+
+	if (f == NULL || !f->reading || len > (uint64_t)f->next) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	f->next -= len;
+
+	return 0;
+}
+
+int bitio_align(struct bitio *f) {
+
+	if (f == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (f->next % 8 == 0)
+		return 0;
+	if (f->reading) { // the rest of the byte is in the buffer
+		f->next += 8 - f->next % 8;
+		return 0;
+	}
+	return bitio_write(f, 0, 8 - f->next % 8) < 0 ? -1 : 0;
+}
+
+uint64_t bitio_bytes(const struct bitio *f) {
+
+	return f != NULL ? f->bytes : 0;
+}
@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define DEFAULT_RESET_THRESHOLD	10	/**< Default ratio degradation (percent) of RESET_POLICY_ADAPTIVE. */
+
 #include "common.h"
 
 unsigned char* compute_digest(FILE *fin, const char *md_name, int *size) {
@@ -65,4 +67,71 @@ int path_len(const char* filename) {
 	}
 	
 	return 0;
-}
\ No newline at end of file
+}
+
+static const char *reset_policies[] = { "reset", "freeze", "adaptive", "manual", "recycle" };
+
+uint8_t reset_policy_parse(const char *str, uint8_t *threshold) {
+
+	uint8_t	i;
+	size_t	len;
+	char	*end;
+	long	t;
+
+	if (str == NULL)
+		return RESET_POLICY_ERROR;
+
+	for (i = 0; i < sizeof(reset_policies)/sizeof(*reset_policies); i++) {
+		len = strlen(reset_policies[i]);
+		if (strncmp(str, reset_policies[i], len) != 0)
+			continue;
+
+		if (str[len] == '\0') {
+			if (i == RESET_POLICY_ADAPTIVE)
+				*threshold = DEFAULT_RESET_THRESHOLD;
+			return i;
+		}
+
+		if (i == RESET_POLICY_ADAPTIVE && str[len] == ':') {
+			t = strtol(&str[len+1], &end, 10);
+			if (*end != '\0' || end == &str[len+1] || t < 1 || t > 100)
+				return RESET_POLICY_ERROR;
+			*threshold = t;
+			return i;
+		}
+	}
+
+	return RESET_POLICY_ERROR;
+}
+
+const char* reset_policy_name(uint8_t policy) {
+
+	if (policy >= sizeof(reset_policies)/sizeof(*reset_policies))
+		return "unknown";
+
+	return reset_policies[policy];
+}
+
+static const char *growths[] = { "lzw", "lzap", "lzmw" };
+
+uint8_t growth_parse(const char *str) {
+
+	uint8_t	i;
+
+	if (str == NULL)
+		return GROWTH_ERROR;
+
+	for (i = 0; i < sizeof(growths)/sizeof(*growths); i++)
+		if (strcmp(str, growths[i]) == 0)
+			return i;
+
+	return GROWTH_ERROR;
+}
+
+const char* growth_name(uint8_t growth) {
+
+	if (growth >= sizeof(growths)/sizeof(*growths))
+		return "unknown";
+
+	return growths[growth];
+}
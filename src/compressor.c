@@ -6,52 +6,427 @@
  * @internal
  */
 
+#define _GNU_SOURCE		/**< For SEEK_DATA and SEEK_HOLE. */
+
+#include <endian.h>
 #include <errno.h>
+#include <signal.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "bitio.h"
 #include "common.h"
 #include "compressor.h"
+#include "cpu.h"
 #include "debug.h"
+#include "dictfile.h"
 #include "dictionary.h"
+#include "entropy.h"
 #include "metadata.h"
+#include "phases.h"
+#include "probes.h"
+#include "stats.h"
+#include "telemetry.h"
 #include "verbose.h"
 
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+#define ADAPTIVE_PART	4			/**< RESET_POLICY_ADAPTIVE takes its reference ratio from the last 1/ADAPTIVE_PART of the records filled. */
+#define ADAPTIVE_SPLIT	16			/**< RESET_POLICY_ADAPTIVE measures the frozen dictionary over 1/ADAPTIVE_SPLIT of the input its reference took. */
+#define ADAPTIVE_WINDOW	(2*1024)	/**< Fewest input bytes over which RESET_POLICY_ADAPTIVE measures the ratio. */
+#define IN_BLOCK		(64*1024)	/**< Bytes of the input read at once: progress is reported between blocks. */
+#define CODE_BLOCK		(12*1024)	/**< Bytes of @c ENTROPY_BYTES codes written at once. */
+#define CODE_BATCH		1024		/**< Codes of one width packed at once. */
+#define RUN_MIN			128			/**< Shortest run of a byte coded with RUN_SYMBOL. */
+#define STORED_MIN		4096		/**< Shortest block of the input that may be stored. */
+#define STORED_ENTROPY	7.8			/**< Bits per byte of the byte histogram from which a block is stored. */
+#define STORED_EXPANDED	6.0			/**< Bits per byte from which a block is stored after a coded block that expanded. */
+#define STORED_PROBE	16			/**< One in this many blocks stored because the last coded one expanded is coded. */
+
+/**
+ * @internal
+ * Codes of the @c ENTROPY_BYTES format not written yet.
+ */
+struct code_block {
+	uint8_t		width;							/**< Bytes of each code, 2 or 3. */
+	uint32_t	len;							/**< Bytes of codes in buf. */
+	uint8_t		buf[CODE_BLOCK];				/**< Codes, little-endian. */
+};
+
+/**
+ * @internal
+ * Codes of one width not written yet.
+ */
+struct code_batch {
+	uint8_t		bits;				/**< Bits of each code. */
+	uint32_t	n;					/**< Number of codes in codes. */
+	uint32_t	codes[CODE_BATCH];	/**< Codes, in the order they are written. */
+};
+
+/**
+ * Set by compress_reset_request() and cleared when the dictionary is reset.
+ * @internal
+ */
+static volatile sig_atomic_t reset_requested = 0;
+
 /**
  * @internal
- * Writes @p index on @p f using @p bits bits.
+ * Writes the codes of @p q on @p f and empties it.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int batch_flush(struct bitio* f, struct code_batch* q) {
+
+	if (q->n != 0 && bitio_write_codes(f, q->codes, q->n, q->bits) < 0)
+		return -1;
+	q->n = 0;
+	return 0;
+}
+
+/**
+ * @internal
+ * Appends @p index, on @p bits bits, to the codes of @p q. The codes
+ * before it are written first if they have another width.
  *
  *	@param	f		Pointer to bitio context in which write the bits.
+ *	@param	q		Codes not written yet.
  *	@param	index	Index in the dictionary to be emitted.
  *	@param	bits	Number of bits used to represent the index.
  *
  *	@return	@c 0 on success, @c -1 otherwise.
  */
-int emit(struct bitio* f, uint32_t index, uint8_t bits) {
+static inline int batch_put(struct bitio* f, struct code_batch* q, uint32_t index, uint8_t bits) {
+
 	LOG("Emitted index: %d on %d bits", index, bits);
+	STATS_CODE(bits);
+
+	if (q->n == CODE_BATCH || (q->n != 0 && q->bits != bits))
+		if (batch_flush(f, q) < 0)
+			return -1;
+	q->bits = bits;
+	q->codes[q->n++] = index;
+	return 0;
+}
 
-	if (bitio_write(f, (uint64_t) index, bits) != bits)
+/**
+ * @internal
+ * Writes the codes of @p b on @p f and empties it.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int block_flush(struct bitio* f, struct code_block* b) {
+
+	if (b->len != 0 && bitio_write_bytes(f, b->buf, b->len) < 0)
 		return -1;
+	b->len = 0;
+	return 0;
+}
+
+/**
+ * @internal
+ * Appends @p index to the codes of @p b: a plain 4-byte store, the byte
+ * past the code is overwritten by the next one.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static inline int block_put(struct bitio* f, struct code_block* b, uint32_t index) {
+
+	uint32_t v = htole32(index);
+
+	LOG("Emitted index: %d on %d bytes", index, b->width);
+	STATS_CODE(8 * b->width);
+
+	memcpy(b->buf + b->len, &v, sizeof(v));
+	b->len += b->width;
+	if (b->len > CODE_BLOCK - sizeof(uint32_t))
+		return block_flush(f, b);
 	return 0;
 }
 
-int64_t compress(const char* in_filename, const char* out_filename, uint32_t dict_size, uint32_t ht_size, uint8_t flags) {
+/**
+ * @internal
+ * Writes @p index with entropy coder @p e if it is not @c NULL, in code
+ * block @p b if it is not @c NULL, on @p bits bits of @p f through code
+ * batch @p q otherwise. @p n is the number of valid indexes.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static inline int put(struct bitio* f, struct entropy* e, struct code_block* b, struct code_batch* q, uint32_t index, uint8_t bits, uint32_t n) {
+
+	if (e != NULL)
+		return entropy_put(e, index, n);
+	if (b != NULL)
+		return block_put(f, b, index);
+	return batch_put(f, q, index, bits);
+}
+
+/**
+ * @internal
+ * Writes @p len as put() does: the number of its digits in base 256, then
+ * the digits from the least significant one.
+ *
+ *	@return	The number of codes written on success, @c -1 otherwise.
+ */
+static int put_length(struct bitio* f, struct entropy* e, struct code_block* b, struct code_batch* q, uint64_t len, uint8_t bits, uint32_t n) {
+
+	uint8_t	digits[sizeof(len)];
+	int		k = 0, i;
+
+	for (; len != 0; len >>= 8)
+		digits[k++] = len & 0xFF;
+	if (put(f, e, b, q, k, bits, n) < 0)
+		return -1;
+	for (i = 0; i < k; i++)
+		if (put(f, e, b, q, digits[i], bits, n) < 0)
+			return -1;
+	return 1 + k;
+}
+
+/**
+ * @internal
+ * Writes the @p len bytes of @p buf as they are, after @c STORED_SYMBOL and
+ * their number: the codes before them are written, and the bytes start at
+ * a byte boundary of @p f. Only for streams without entropy coding.
+ *
+ *	@return	The number of codes written on success, @c -1 otherwise.
+ */
+static int put_stored(struct bitio* f, struct code_block* b, struct code_batch* q, const uint8_t* buf, size_t len, uint8_t bits, uint32_t n) {
+
+	int codes;
+
+	if (put(f, NULL, b, q, STORED_SYMBOL, bits, n) < 0 || (codes = put_length(f, NULL, b, q, len, bits, n)) < 0)
+		return -1;
+	if ((b != NULL ? block_flush(f, b) : batch_flush(f, q)) < 0 || bitio_align(f) < 0 || bitio_write_bytes(f, buf, len) < 0)
+		return -1;
+	return 1 + codes;
+}
+
+/**
+ * @internal
+ * Returns the entropy of the byte histogram of the @p n bytes of @p p, in
+ * bits per byte: how many bits the bytes take at least when each is coded
+ * on its own. Phrases do better only when the bytes repeat in sequences.
+ */
+static double byte_entropy(const uint8_t* p, size_t n) {
+
+	uint32_t	count[4][NUM_SYMBOLS] = { { 0 } }, c, e;
+	double		sum = 0, m;
+	size_t		i;
+
+	// four histograms, so that equal bytes in a row do not wait for each other
+	for (i = 0; i + 4 <= n; i += 4) {
+		count[0][p[i]]++;
+		count[1][p[i + 1]]++;
+		count[2][p[i + 2]]++;
+		count[3][p[i + 3]]++;
+	}
+	for (; i < n; i++)
+		count[0][p[i]]++;
+
+	// sum of c * log2(c), with log2 of the mantissa approximated by a parabola (error under 0.01)
+	for (i = 0; i < NUM_SYMBOLS; i++) {
+		c = count[0][i] + count[1][i] + count[2][i] + count[3][i];
+		if (c > 1) {
+			e = 31 - __builtin_clz(c);
+			m = (double)c / ((uint32_t)1 << e) - 1;
+			sum += c * (e + m * (1.3466 - 0.3466 * m));
+		}
+	}
+	e = 63 - __builtin_clzll(n);
+	m = (double)n / ((uint64_t)1 << e) - 1;
+	return e + m * (1.3466 - 0.3466 * m) - sum / n;
+}
+
+/**
+ * Returns the number of bytes equal to @p v at the start of the @p n bytes
+ * of @p p.
+ * @internal
+ */
+typedef size_t (*run_fn)(const uint8_t* p, size_t n, uint8_t v);
+
+/**
+ * Compares 8 bytes at a time.
+ * @internal
+ */
+static size_t run_generic(const uint8_t* p, size_t n, uint8_t v) {
+
+	uint64_t	w, pattern = 0x0101010101010101ULL * v;
+	size_t		i = 0;
+
+	for (; i + sizeof(w) <= n; i += sizeof(w)) {
+		memcpy(&w, p + i, sizeof(w));
+		if (w != pattern)
+			break;
+	}
+	while (i < n && p[i] == v)
+		i++;
+	return i;
+}
+
+#ifdef CPU_X86
+/**
+ * Compares 16 bytes at a time.
+ * @internal
+ */
+static __attribute__((target("sse4.2"))) size_t run_sse42(const uint8_t* p, size_t n, uint8_t v) {
+
+	const __m128i	pattern = _mm_set1_epi8(v);
+	unsigned		eq;
+	size_t			i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		eq = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), pattern));
+		if (eq != 0xFFFF)
+			return i + __builtin_ctz(~eq);
+	}
+	return i + run_generic(p + i, n - i, v);
+}
+
+/**
+ * Compares 64 bytes at a time, in two 32-byte vectors.
+ * @internal
+ */
+static __attribute__((target("avx2"))) size_t run_avx2(const uint8_t* p, size_t n, uint8_t v) {
+
+	const __m256i	pattern = _mm256_set1_epi8(v);
+	__m256i			a, b;
+	uint32_t		eq;
+	size_t			i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), pattern);
+		b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 32)), pattern);
+		if (_mm256_movemask_epi8(_mm256_and_si256(a, b)) != -1) {
+			eq = _mm256_movemask_epi8(a);
+			if (eq != 0xFFFFFFFF)
+				return i + __builtin_ctz(~eq);
+			return i + 32 + __builtin_ctz(~(uint32_t)_mm256_movemask_epi8(b));
+		}
+	}
+	return i + run_sse42(p + i, n - i, v);
+}
+#endif
+
+/**
+ * Run kernels by CPU level.
+ * @internal
+ */
+static const run_fn runs[CPU_LEVELS] = {
+	run_generic,
+#ifdef CPU_X86
+	run_sse42,
+	run_avx2,
+	run_avx2,
+#else
+	run_generic,
+	run_generic,
+	run_generic,
+#endif
+};
+
+/**
+ * @internal
+ * Indicates if regular file @p f of @p size bytes has holes after its
+ * current position.
+ */
+static int has_holes(FILE* f, off_t size) {
+
+	off_t	pos = ftello(f), hole;
+
+	if (pos < 0)
+		return 0;
+	hole = lseek(fileno(f), pos, SEEK_HOLE);
+	return fseeko(f, pos, SEEK_SET) == 0 && hole >= 0 && hole < size;
+}
+
+/**
+ * @internal
+ * If the next byte of regular file @p f of @p size bytes is in a hole,
+ * skips the hole: its bytes are all zeros.
+ *
+ *	@return	The number of bytes skipped, @c -1 if the file system cannot
+ *			tell the holes.
+ */
+static off_t skip_hole(FILE* f, off_t size) {
+
+	off_t	pos = ftello(f), data;
+
+	if (pos < 0)
+		return -1;
+	data = lseek(fileno(f), pos, SEEK_DATA);
+	if (data < 0 && errno == ENXIO) // no data up to the end
+		data = size > pos ? size : pos;
+	if (data < 0 || fseeko(f, data, SEEK_SET) < 0)
+		return -1;
+	return data - pos;
+}
+
+/**
+ * @internal
+ * Reads the next block of @p fin in @p buf, and prints a dot each
+ * @c COUNT_THRESHOLD bytes, counted in @p read_count.
+ *
+ *	@return	The number of bytes read, @c 0 at the end of the input.
+ */
+static size_t read_block(FILE* fin, uint8_t* buf, int* read_count) {
+
+	size_t len = fread(buf, 1, IN_BLOCK, fin);
+
+	*read_count += len;
+	if (VERBOSE_LEVEL > 0 && *read_count >= COUNT_THRESHOLD) {
+		*read_count -= COUNT_THRESHOLD;
+		PRINT(1, ".");
+	}
+	return len;
+}
+
+void compress_reset_request(void) {
+
+	reset_requested = 1;
+}
+
+int64_t compress(const char* in_filename, const char* out_filename, uint32_t dict_size, uint32_t ht_size, uint8_t flags, const struct comp_options* opts) {
 
+	struct comp_options	default_opts = { RESET_POLICY_RESET, 0, GROWTH_LZW, ENTROPY_NONE, 0, 0, NULL, 0 };
 	struct bitio		*bd = bstdout;
 	struct dictionary	*d = NULL;
+	struct entropy		*ec = NULL;
+	struct code_block	*cb = NULL;
+	struct code_batch	*cq = NULL;
+	dict_match_fn		walk = NULL;
+	run_fn				run = NULL;
 	struct stat			file_stat;
 	time_t				t;
 	FILE				*fin = stdin;
 	char				*md5_str;
-	int					c, read_count = 0;
-	uint8_t				bits, initial_bits;
-	uint32_t			bitMask, cur, next_record, y;
-	uint64_t			filesize = 0;
+	int					c, read_count = 0, missed = 0, holes = 0, store = 0, raw = 0, expanding = 0;
+	size_t				in_pos = 0, in_len = 0;
+	uint8_t				in_buf[IN_BLOCK];
+	uint8_t				bits, initial_bits, ctrl_codes = 0;
+	uint32_t			cur, first_record, next_record, y, resets = 0, stored = 0, probes = 0;
+	uint32_t			prev = ROOT_NODE, match = ROOT_NODE, match_len = 0, depth = 0, phrase_size = 0;
+	uint32_t			ahead_pos = 0, ahead_len = 0, ahead_size = 0;
+	uint8_t				*phrase = NULL, *ahead = NULL;
+	uint64_t			filesize = 0, run_len, out_bits = 0, window_start = 0, window_bits = 0, window_len = 0, block_start = 0, block_bits = 0, bitMask;
+	double				ref_ratio = 0;
 	unsigned char		*md5;
 
+	if (opts == NULL)
+		opts = &default_opts;
+	reset_requested = 0;
+	phase_enter(PHASE_META);
+
+
+	// recycling relies on records whose parents are records
+	if (opts->growth > GROWTH_LZMW || opts->entropy > ENTROPY_BYTES || (opts->entropy == ENTROPY_BYTES && dict_size > ENTROPY_BYTES_MAX_SIZE) || (opts->growth != GROWTH_LZW && (opts->reset_policy == RESET_POLICY_RECYCLE || opts->runs))) {
+		errno = EINVAL;
+		goto error;
+	}
 
 	if (out_filename != NULL && in_filename != NULL && strcmp(in_filename, out_filename) == 0) {
 		errno = EINVAL;
@@ -75,11 +450,74 @@ int64_t compress(const char* in_filename, const char* out_filename, uint32_t dic
 		if (meta_write(bd, META_DICT_SIZE, &dict_size, sizeof(dict_size)) < 0)
 			goto error;
 
+	// incompressible blocks are stored on request: the range coder cannot be paused for them
+	store = opts->store && opts->growth == GROWTH_LZW && opts->entropy != ENTROPY_RANGE;
+
+	// the holes of a sparse file are skipped as runs of zeros, if a dictionary file leaves room for RUN_SYMBOL
+	holes = fstat(fileno(fin), &file_stat) == 0 && S_ISREG(file_stat.st_mode) && has_holes(fin, file_stat.st_size);
+	if (opts->growth == GROWTH_LZW && (opts->runs || (holes && (opts->dictfile == NULL || dictfile_first_record(opts->dictfile) > RUN_SYMBOL))))
+		run = runs[cpu_level()];
+
+	// the control codes are the ones up to the last that can be used
+	if (store)
+		ctrl_codes = STORED_SYMBOL - EOF_SYMBOL;
+	else if (run != NULL)
+		ctrl_codes = RUN_SYMBOL - EOF_SYMBOL;
+	else if (opts->reset_policy != RESET_POLICY_RESET) // RESET_SYMBOL is needed to signal resets
+		ctrl_codes = RESET_SYMBOL - EOF_SYMBOL;
+
+	if (opts->dictfile != NULL) { // its records come right after its control codes
+		uint64_t id = dictfile_id(opts->dictfile);
+
+		if (dictfile_first_record(opts->dictfile) < NUM_SYMBOLS + 1 + ctrl_codes) {
+			errno = EINVAL;
+			goto error;
+		}
+		ctrl_codes = dictfile_first_record(opts->dictfile) - NUM_SYMBOLS - 1;
+		if (meta_write(bd, META_DICT_ID, &id, sizeof(id)) < 0)
+			goto error;
+		PRINT(1, "Dictionary File:\t%016llx\n", (unsigned long long)id);
+	}
+
+	if (ctrl_codes != 0)
+		if (meta_write(bd, META_CTRL_CODES, &ctrl_codes, sizeof(ctrl_codes)) < 0)
+			goto error;
+
+	if (opts->reset_policy != RESET_POLICY_RESET) {
+		if (meta_write(bd, META_RESET_POLICY, &opts->reset_policy, sizeof(opts->reset_policy)) < 0)
+			goto error;
+		PRINT(1, "Reset Policy:\t\t%s\n", reset_policy_name(opts->reset_policy));
+	}
+
+	if (opts->growth != GROWTH_LZW) {
+		if (meta_write(bd, META_GROWTH, &opts->growth, sizeof(opts->growth)) < 0)
+			goto error;
+		PRINT(1, "Dictionary Growth:\t%s\n", growth_name(opts->growth));
+	}
+
+	if (opts->max_memory != 0) { // the decompressor can tell why these sizes
+		if (meta_write(bd, META_MAX_MEMORY, &opts->max_memory, sizeof(opts->max_memory)) < 0 || meta_write(bd, META_HT_SIZE, &ht_size, sizeof(ht_size)) < 0)
+			goto error;
+		PRINT(1, "Memory Budget:\t\t%.3f MB\n", (double)opts->max_memory/(1024*1024));
+	}
+
+	if (opts->entropy != ENTROPY_NONE) {
+		if (meta_write(bd, META_ENTROPY, &opts->entropy, sizeof(opts->entropy)) < 0)
+			goto error;
+		PRINT(1, "Entropy Coding:\t\t%s\n", opts->entropy == ENTROPY_RANGE ? "Range" : "Bytes");
+	}
+
+	if (run != NULL) {
+		PRINT(1, "Runs:\t\t\t%s\n", holes ? "Yes, skipping holes" : "Yes");
+	}
+
 	if (flags & META_MD5) {
 		if (fin != stdin) {
 			int md5_size;
 
+			phase_enter(PHASE_DIGEST);
 			md5 = compute_digest(fin, "md5", &md5_size);
+			phase_enter(PHASE_META);
 			if (meta_write(bd, META_MD5, md5, md5_size) < 0)
 				goto error;
 			md5_str = sprinth(md5, md5_size);
@@ -107,12 +545,43 @@ int64_t compress(const char* in_filename, const char* out_filename, uint32_t dic
 	if (meta_finalize(bd) < 0)
 		goto error;
 
+	phase_enter(PHASE_DICT);
 	d = dict_new(dict_size, 1, ht_size, NUM_SYMBOLS);
 
 	if (d == NULL)
 		goto error;
 
-	next_record = dict_init(d);
+	if (opts->reset_policy == RESET_POLICY_RECYCLE && dict_track_uses(d) < 0)
+		goto error;
+
+	if (opts->growth != GROWTH_LZW && dict_set_growth(d, opts->growth) < 0)
+		goto error;
+
+	first_record = dict_init(d) + ctrl_codes;
+
+	// the records of the dictionary file are never reset nor recycled
+	if (opts->dictfile != NULL) {
+		first_record = dict_set_base(d, dictfile_dict(opts->dictfile), first_record);
+		if (first_record == 0)
+			goto error;
+	}
+	next_record = first_record;
+
+	// lzw phrases are walked by a kernel specialized for the dictionary
+	if (opts->growth == GROWTH_LZW) {
+		walk = dict_match_kernel(d);
+		if (walk == NULL)
+			goto error;
+	}
+
+	// size the hash table on the input: phrases are rarely shorter than 2 bytes on average
+	if (fstat(fileno(fin), &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+		if (dict_reserve(d, file_stat.st_size / 2 < dict_size ? file_stat.st_size / 2 : dict_size) < 0)
+			goto error;
+		telemetry_start("compress", file_stat.st_size);
+	}
+	else
+		telemetry_start("compress", 0);
 	initial_bits = 0;
 	bitMask = 1;
 	while (bitMask < next_record) {
@@ -120,68 +589,349 @@ int64_t compress(const char* in_filename, const char* out_filename, uint32_t dic
 		initial_bits++;
 	}
 	bits = initial_bits;
-	bitMask = 1 << bits;
-	
+	bitMask = (uint64_t)1 << bits;
+
+	if (opts->entropy == ENTROPY_RANGE) {
+		ec = entropy_new(bd, 1, NUM_SYMBOLS + 1 + ctrl_codes);
+		if (ec == NULL)
+			goto error;
+	}
+	else if (opts->entropy == ENTROPY_BYTES) {
+		cb = malloc(sizeof(*cb));
+		if (cb == NULL)
+			goto error;
+		cb->width = ENTROPY_BYTES_WIDTH(dict_size);
+		cb->len = 0;
+	}
+	else {
+		cq = malloc(sizeof(*cq));
+		if (cq == NULL)
+			goto error;
+		cq->n = 0;
+	}
+
+	phase_enter(PHASE_LOOP);
 	cur = ROOT_NODE;
 	for(;;) {
-  		c = fgetc(fin);
-		if (c == EOF) {
+		if (ahead_pos < ahead_len) // symbols read past the last emitted phrase
+			c = ahead[ahead_pos++];
+		else {
+			if (in_pos == in_len) { // next block, the only place where progress is reported
+				if (in_len != 0)
+					PROBE3(block_end, 0, filesize, bitio_bytes(bd));
+				telemetry_update(filesize, bitio_bytes(bd), resets);
+				in_len = read_block(fin, in_buf, &read_count);
+				in_pos = 0;
+				if (in_len != 0)
+					PROBE3(block_start, 0, filesize, bitio_bytes(bd));
+
+				// a block that would take more than its bytes is stored as it is
+				raw = 0;
+				if (store && in_len >= STORED_MIN) {
+					double h = byte_entropy(in_buf, in_len);
+
+					if (filesize > block_start) // the last block was coded
+						expanding = out_bits - block_bits > 8 * (filesize - block_start);
+					raw = h >= STORED_ENTROPY || (expanding && h >= STORED_EXPANDED && ++probes % STORED_PROBE != 0);
+				}
+				block_start = filesize;
+				block_bits = out_bits;
+			}
 
-			//emit last word
-			if (emit(bd, cur, bits) < 0)
-				goto error;
+			// the rest of a block to store: the phrase before it, if any, ended at a miss
+			if (raw && cur == ROOT_NODE && in_pos < in_len) {
+				int codes = put_stored(bd, cb, cq, in_buf + in_pos, in_len - in_pos, bits, next_record);
+
+				if (codes < 0)
+					goto error;
+				LOG("Stored %zu bytes", in_len - in_pos);
+				STATS_PHRASE(in_len - in_pos);
+				out_bits += codes * (cb != NULL ? 8 * cb->width : bits) + 8 * (in_len - in_pos);
+				filesize += in_len - in_pos;
+				in_pos = in_len;
+				block_start = filesize;
+				block_bits = out_bits;
+				stored++;
+				continue;
+			}
+
+			// follow the symbols of the block while the dictionary has them:
+			// the first one it has not is read as usual, already looked up
+			if (walk != NULL && in_pos < in_len) {
+				uint32_t n = walk(d, &cur, in_buf + in_pos, in_len - in_pos, &y);
+
+				in_pos += n;
+				filesize += n;
+				if (in_pos == in_len)
+					continue;
+				missed = 1;
+			}
+
+			if (in_pos < in_len) {
+				c = in_buf[in_pos++];
+				filesize++;
+			}
+			else
+				c = EOF;
+		}
+
+		if (c == EOF && (opts->growth == GROWTH_LZW || cur == ROOT_NODE)) {
+
+			//emit last word (there is none if input is empty)
+			if (cur != ROOT_NODE) {
+				if (put(bd, ec, cb, cq, cur, bits, next_record) < 0)
+					goto error;
+				STATS_PHRASE(filesize - stats_counters.phrase_bytes); // phrases cover the input
+			}
 
 			//emit EOF
 			dict_lookup(d, ROOT_NODE, EOF_SYMBOL, &y);
 
-			if (emit(bd, y, bits) < 0)
+			if (put(bd, ec, cb, cq, y, bits, next_record) < 0)
+				goto error;
+
+			phase_enter(PHASE_FLUSH);
+			if (ec != NULL && entropy_flush(ec) < 0)
+				goto error;
+			if (cb != NULL && block_flush(bd, cb) < 0)
+				goto error;
+			if (cq != NULL && batch_flush(bd, cq) < 0)
 				goto error;
 
 			break;
 		}
-		
-		filesize++;
 
-		if (VERBOSE_LEVEL > 0 && ++read_count >= COUNT_THRESHOLD) {
-			read_count = 0;
-			PRINT(1, ".");
-		}
+		if (c == EOF || missed || !dict_lookup(d, cur, (uint16_t) c, &y)) { //node not found
 
-		if (!dict_lookup(d, cur, (uint16_t) c, &y)) { //node not found
+			missed = 0;
 
-			if (emit(bd, cur, bits) < 0)
+			if (opts->growth != GROWTH_LZW) // the walk may have gone past the longest phrase
+				cur = match;
+
+			if (put(bd, ec, cb, cq, cur, bits, next_record) < 0)
 				goto error;
+			out_bits += cb != NULL ? 8 * cb->width : bits;
+			dict_use(d, cur);
+			STATS_PHRASE(opts->growth == GROWTH_LZW ? filesize - (c != EOF) - stats_counters.phrase_bytes : match_len);
+
+			if (next_record < dict_size) { // dictionary is not frozen
+				if (opts->growth == GROWTH_LZW) {
+					if (!dict_fill(d, y, cur, (uint16_t) c, next_record++))
+						goto error;
+					if (next_record & bitMask) {
+						bitMask <<= 1;
+						bits++;
+					}
+				}
+				else {
+					if (prev != ROOT_NODE) {
+						next_record = dict_grow(d, prev, phrase, match_len, next_record);
+						if (next_record == 0)
+							goto error;
+						while (bitMask < next_record) {
+							bitMask <<= 1;
+							bits++;
+						}
+					}
+					prev = cur;
+				}
+
+				// the ratio of the last records filled is the reference of the frozen dictionary
+				if (opts->reset_policy == RESET_POLICY_ADAPTIVE && window_len == 0 && next_record >= dict_size - (dict_size - first_record) / ADAPTIVE_PART) {
+					window_start = filesize;
+					window_bits = out_bits;
+					window_len = 1;
+				}
+
+				if (next_record == dict_size) {
+					if (opts->reset_policy == RESET_POLICY_RESET) {
+						phase_enter(PHASE_RESET);
+						PROBE4(dict_reset, 0, filesize, next_record, bits);
+						dict_reinit(d);
+						next_record = first_record;
+						bits = initial_bits;
+						bitMask = (uint64_t)1 << bits;
+						prev = ROOT_NODE;
+						resets++;
+						phase_enter(PHASE_LOOP);
+					}
+					else if (opts->reset_policy == RESET_POLICY_RECYCLE) { // keep the most used half
+						phase_enter(PHASE_RESET);
+						PROBE4(dict_reset, 0, filesize, next_record, bits);
+						next_record = dict_recycle(d, first_record, next_record, (dict_size - first_record) / 2);
+						if (next_record == 0)
+							goto error;
+						bits = initial_bits;
+						bitMask = (uint64_t)1 << bits;
+						while (bitMask < next_record) {
+							bitMask <<= 1;
+							bits++;
+						}
+						resets++;
+						phase_enter(PHASE_LOOP);
+					}
+					else if (opts->reset_policy == RESET_POLICY_ADAPTIVE) {
+						// freeze it; the reference is the best ratio a dictionary
+						// reached while growing, so that a dictionary learnt on
+						// incompressible data does not stay frozen on what follows
+						uint64_t grown = filesize - window_start;
+
+						if (grown > 0 && (ref_ratio == 0 || (double)(out_bits - window_bits) / grown < ref_ratio))
+							ref_ratio = (double)(out_bits - window_bits) / grown;
+						window_len = grown / ADAPTIVE_SPLIT > ADAPTIVE_WINDOW ? grown / ADAPTIVE_SPLIT : ADAPTIVE_WINDOW;
+						window_start = filesize;
+						window_bits = out_bits;
+					}
+				}
+			}
+			else if (opts->reset_policy == RESET_POLICY_ADAPTIVE && filesize - window_start >= window_len) {
+				// a fresh dictionary is expected to do as well as the best one did while growing
+				if (ref_ratio > 0 && (double)(out_bits - window_bits) / (filesize - window_start) * 100 > ref_ratio * (100 + opts->reset_threshold))
+					reset_requested = 1;
+				window_start = filesize;
+				window_bits = out_bits;
+			}
 
-			dict_fill(d, y, cur, (uint16_t) c, next_record++);
-			if (next_record & bitMask) {
-				bitMask <<= 1;
-				bits++;
+			if (reset_requested && (opts->reset_policy == RESET_POLICY_ADAPTIVE || opts->reset_policy == RESET_POLICY_MANUAL)) {
+				reset_requested = 0;
+				if (next_record > first_record) {
+					LOG("Dictionary reset requested after %llu bytes", (unsigned long long)filesize);
+					if (put(bd, ec, cb, cq, RESET_SYMBOL, bits, next_record) < 0)
+						goto error;
+					out_bits += cb != NULL ? 8 * cb->width : bits;
+
+					phase_enter(PHASE_RESET);
+					PROBE4(dict_reset, 0, filesize, next_record, bits);
+					dict_reinit(d);
+					next_record = first_record;
+					bits = initial_bits;
+					bitMask = (uint64_t)1 << bits;
+					prev = ROOT_NODE;
+					window_len = 0;
+					resets++;
+					phase_enter(PHASE_LOOP);
+				}
 			}
 
-			if (next_record == dict_size) {
-				next_record = dict_reinit(d);
-				bits = initial_bits;
-				bitMask = 1 << bits;
+			if (raw) { // the stored bytes start from c
+				in_pos--;
+				filesize--;
+				cur = ROOT_NODE;
+				continue;
 			}
 
-			// search again starting from last unmatched symbol
-			dict_lookup(d, ROOT_NODE, (uint16_t) c, &y);
+			// a long run of c: its byte and length, in base 256, follow RUN_SYMBOL
+			if (run != NULL && c != EOF && in_len - in_pos >= RUN_MIN - 1 && in_buf[in_pos] == c && (run_len = run(in_buf + in_pos, RUN_MIN - 1, c)) == RUN_MIN - 1) {
+				int codes;
+
+				in_pos += run_len;
+				run_len++;
+				for (;;) {
+					size_t n = run(in_buf + in_pos, in_len - in_pos, c);
+
+					in_pos += n;
+					run_len += n;
+					if (in_pos < in_len)
+						break;
+					if (c == 0 && holes) { // a hole is a run of zeros that needs no reading
+						off_t skipped = skip_hole(fin, file_stat.st_size);
+
+						if (skipped < 0)
+							holes = 0;
+						else
+							run_len += skipped;
+					}
+					telemetry_update(filesize + run_len - 1, bitio_bytes(bd), resets);
+					in_len = read_block(fin, in_buf, &read_count);
+					in_pos = 0;
+					if (in_len == 0)
+						break;
+				}
+				LOG("Run of %llu bytes %d", (unsigned long long)run_len, c);
+				filesize += run_len - 1;
+				STATS_PHRASE(run_len);
+
+				if (put(bd, ec, cb, cq, RUN_SYMBOL, bits, next_record) < 0 || put(bd, ec, cb, cq, c, bits, next_record) < 0 || (codes = put_length(bd, ec, cb, cq, run_len, bits, next_record)) < 0)
+					goto error;
+				out_bits += (2 + codes) * (cb != NULL ? 8 * cb->width : bits);
+
+				cur = ROOT_NODE;
+				continue;
+			}
+
+			if (opts->growth == GROWTH_LZW) {
+				// search again starting from last unmatched symbol
+				dict_lookup(d, ROOT_NODE, (uint16_t) c, &y);
+			}
+			else {
+				// read again the symbols after the emitted phrase
+				uint32_t rest = ahead_len - ahead_pos, n = depth - match_len + (c != EOF) + rest;
+
+				if (n > ahead_size) {
+					uint8_t *reallocated = realloc(ahead, 2 * n);
+					if (reallocated == NULL)
+						goto error;
+					ahead = reallocated;
+					ahead_size = 2 * n;
+				}
+				memmove(ahead + n - rest, ahead + ahead_pos, rest);
+				memcpy(ahead, phrase + match_len, depth - match_len);
+				if (c != EOF)
+					ahead[n - rest - 1] = c;
+				ahead_pos = 0;
+				ahead_len = n;
+
+				cur = ROOT_NODE;
+				depth = 0;
+				continue;
+			}
 		}
 
 		cur = dict_next(d, y);
+
+		if (opts->growth != GROWTH_LZW) { // keep the symbols of the walk
+			if (depth == phrase_size) {
+				uint8_t *reallocated = realloc(phrase, 2 * phrase_size + 64);
+				if (reallocated == NULL)
+					goto error;
+				phrase = reallocated;
+				phrase_size = 2 * phrase_size + 64;
+			}
+			phrase[depth++] = c;
+			if (cur < dict_size) { // not an intermediate node
+				match = cur;
+				match_len = depth;
+			}
+		}
 	}
 
+	PRINT(1, "\nDictionary Resets:\t%u", resets);
+	PRINT(1, "\nStored Blocks:\t\t%u", stored);
 	PRINT(1, "\nCompression Finished\n\n");
-	dict_delete(d);
 	bitio_flush(bd);
+	telemetry_end(filesize, bitio_bytes(bd), resets);
+	phase_enter(PHASE_CLOSE);
+	free(phrase);
+	free(ahead);
+	free(cb);
+	free(cq);
+	entropy_delete(ec);
+	dict_delete(d);
 	if (bd != bstdout)
 		bitio_close(bd);
 	if (fin != NULL)
 		fclose(fin);
+	phase_enter(PHASE_NONE);
 	return filesize;
 
 error:
+	phase_enter(PHASE_NONE);
 	PRINT(1, "\n");
+	free(phrase);
+	free(ahead);
+	free(cb);
+	free(cq);
+	entropy_delete(ec);
 	dict_delete(d);
 	bitio_flush(bd);
 	if (bd != bstdout)
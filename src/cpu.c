@@ -0,0 +1,71 @@
+/**
+ * @file	cpu.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for the CPU features that select the vectorized kernels.
+ * @internal
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "debug.h"
+
+#define CPU_DEFAULT_MAX	CPU_AVX2	/**< Highest level picked without @c LZ78_SIMD: the 512-bit kernels were slower. */
+
+static const char* const level_names[CPU_LEVELS] = { "generic", "sse4.2", "avx2", "avx512" };	/**< Names of the levels, as @c LZ78_SIMD takes them. */
+
+static int	level = -1;	/**< Level found by the first cpu_level() call, @c -1 before it. */
+
+/**
+ * Returns the highest level the CPU supports.
+ * @internal
+ */
+static uint8_t cpu_detect(void) {
+
+#ifdef CPU_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+		return CPU_AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return CPU_AVX2;
+	if (__builtin_cpu_supports("sse4.2"))
+		return CPU_SSE42;
+#endif
+	return CPU_GENERIC;
+}
+
+uint8_t cpu_level(void) {
+
+	const char	*env;
+	int			i, detected;
+
+	if (level >= 0)
+		return level;
+
+	detected = cpu_detect();
+	level = detected < CPU_DEFAULT_MAX ? detected : CPU_DEFAULT_MAX;
+	LOG("CPU level: %s (default %s)", level_names[detected], level_names[level]);
+
+	// a test may ask for any level the CPU has
+	env = getenv("LZ78_SIMD");
+	if (env != NULL) {
+		for (i = 0; i < CPU_LEVELS && strcmp(env, level_names[i]) != 0; i++);
+		if (i == CPU_LEVELS)
+			fprintf(stderr, "Warning: unknown LZ78_SIMD level %s, using %s\n", env, level_names[level]);
+		else if (i > detected)
+			fprintf(stderr, "Warning: LZ78_SIMD level %s not supported by the CPU, using %s\n", env, level_names[level]);
+		else
+			level = i;
+		LOG("LZ78_SIMD=%s, CPU level: %s", env, level_names[level]);
+	}
+
+	return level;
+}
+
+const char* cpu_level_name(uint8_t l) {
+
+	return l < CPU_LEVELS ? level_names[l] : "unknown";
+}
@@ -6,11 +6,14 @@
  * @internal
  */
 
+#include <endian.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <openssl/evp.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <utime.h>
 
@@ -18,45 +21,277 @@
 #include "common.h"
 #include "debug.h"
 #include "decompressor.h"
+#include "dictfile.h"
 #include "dictionary.h"
+#include "entropy.h"
+#include "memlimit.h"
 #include "metadata.h"
+#include "phases.h"
+#include "probes.h"
+#include "stats.h"
+#include "telemetry.h"
 #include "verbose.h"
 
+#define CODE_BLOCK		(12*1024)	/**< Bytes of @c ENTROPY_BYTES codes read at once. */
+#define OUT_BLOCK		(64*1024)	/**< Bytes of words gathered before writing them. */
+#define CODE_BATCH		1024		/**< Codes of one width unpacked at once. */
+
+/**
+ * @internal
+ * Codes of the @c ENTROPY_BYTES format read and not decoded yet.
+ */
+struct code_block {
+	uint8_t		width;								/**< Bytes of each code, 2 or 3. */
+	uint32_t	mask;								/**< Mask of the bits of a code. */
+	uint32_t	pos;								/**< Offset of the next code in buf. */
+	uint32_t	len;								/**< Bytes of codes in buf. */
+	uint8_t		buf[CODE_BLOCK + sizeof(uint32_t)];	/**< Codes, padded so that a code is read with a 4-byte load. */
+};
+
+/**
+ * @internal
+ * Codes of one width read and not decoded yet.
+ */
+struct code_batch {
+	uint8_t		bits;				/**< Bits of each code. */
+	uint32_t	pos;				/**< Position of the next code in codes. */
+	uint32_t	n;					/**< Number of codes in codes. */
+	uint32_t	codes[CODE_BATCH];	/**< Codes, in the order they were read. */
+};
+
+/**
+ * @internal
+ * Returns the next code of @p b, reading more codes from @p f when it has
+ * not a whole one left.
+ *
+ *	@return	The fetched index on success, ROOT_NODE on failure.
+ */
+static inline uint32_t fetch_block(struct bitio* f, struct code_block* b) {
+
+	uint32_t	v;
+	int64_t		n;
+
+	if (b->len - b->pos < b->width) {
+		memmove(b->buf, b->buf + b->pos, b->len - b->pos);
+		b->len -= b->pos;
+		b->pos = 0;
+		n = bitio_read_bytes(f, b->buf + b->len, CODE_BLOCK - b->len);
+		if (n < 0 || b->len + n < b->width)
+			return ROOT_NODE;
+		b->len += n;
+	}
+
+	memcpy(&v, b->buf + b->pos, sizeof(v));
+	b->pos += b->width;
+	STATS_CODE(8 * b->width);
+
+	return le32toh(v) & b->mask;
+}
+
+/**
+ * @internal
+ * Writes the @p len bytes of @p buf on @p f, and adds them to the digest
+ * @p md_ctx unless it is @c NULL.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int out_write(FILE* f, const void* buf, size_t len, EVP_MD_CTX* md_ctx) {
+
+	if (fwrite(buf, 1, len, f) < len)
+		return -1;
+	if (md_ctx != NULL)
+		EVP_DigestUpdate(md_ctx, buf, len);
+	return 0;
+}
+
 /**
  * @internal
- * Reads @p bits bits from @p f and returns the fetched number.
+ * Returns the next code of @p bits bits, from the codes of @p q, reading
+ * more of them from @p f when it has none left. The codes of @p q were read
+ * with the width of the previous call: if @p bits is another one, they are
+ * given back to @p f and read again.
  *
  *	@param	f		Pointer to bitio context from which read the bits.
+ *	@param	q		Codes read and not decoded yet.
  *	@param	bits	Number of bits to read.
  *
  *	@return	The fetched index on success, ROOT_NODE on failure.
  */
-uint32_t fetch(struct bitio* f, uint8_t bits) {
+static inline uint32_t fetch(struct bitio* f, struct code_batch* q, uint8_t bits) {
+
+	int64_t n;
+
+	if (q->pos == q->n || q->bits != bits) {
+		if (q->pos < q->n && bitio_unread(f, (uint64_t)(q->n - q->pos) * q->bits) < 0)
+			return ROOT_NODE;
+		n = bitio_read_codes(f, q->codes, CODE_BATCH, bits);
+		if (n <= 0)
+			return ROOT_NODE;
+		q->bits = bits;
+		q->pos = 0;
+		q->n = n;
+	}
+	STATS_CODE(bits);
+
+	return q->codes[q->pos++];
+}
 
-	uint64_t	index;
+/**
+ * @internal
+ * Returns the next code: from entropy decoder @p e if it is not @c NULL,
+ * from code block @p b if it is not @c NULL, on @p bits bits of @p f through
+ * code batch @p q otherwise. @p n is the number of valid indexes.
+ *
+ *	@return	The fetched index on success, ROOT_NODE on failure.
+ */
+static inline uint32_t get(struct bitio* f, struct entropy* e, struct code_block* b, struct code_batch* q, uint8_t bits, uint32_t n) {
 
-	if (bitio_read(f, &index, bits) < bits)
-		return ROOT_NODE;
+	uint32_t index;
 
-	return index;
+	if (e != NULL)
+		return entropy_get(e, n, &index) < 0 ? ROOT_NODE : index;
+	if (b != NULL)
+		return fetch_block(f, b);
+	return fetch(f, q, bits);
 }
 
-int64_t decompress(const char* in_filename, const char* out_filename, uint8_t flags) {
+/**
+ * @internal
+ * Adds @p len bytes to the @p *write_count written since the last report
+ * and, each @c COUNT_THRESHOLD bytes, moves them to @p *filesize and
+ * reports the progress.
+ */
+static inline void progress(struct bitio* f, uint64_t* filesize, uint64_t* write_count, uint64_t len, uint32_t resets) {
+
+	*write_count += len;
+	if (*write_count >= COUNT_THRESHOLD) {
+		*filesize += *write_count;
+		*write_count = 0;
+		PRINT(1, ".");
+		PROBE3(block_end, 1, bitio_bytes(f), *filesize);
+		telemetry_update(bitio_bytes(f), *filesize, resets);
+		PROBE3(block_start, 1, bitio_bytes(f), *filesize);
+	}
+}
+
+/**
+ * @internal
+ * Reads a length written by the compressor's put_length(): the number of
+ * its digits in base 256, then the digits from the least significant one.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int get_length(struct bitio* f, struct entropy* e, struct code_block* b, struct code_batch* q, uint8_t bits, uint32_t n, uint64_t* len) {
+
+	uint32_t	k = get(f, e, b, q, bits, n), digit, i;
+
+	if (k == 0 || k > sizeof(*len))
+		return -1;
+	*len = 0;
+	for (i = 0; i < k; i++) {
+		digit = get(f, e, b, q, bits, n);
+		if (digit >= NUM_SYMBOLS)
+			return -1;
+		*len |= (uint64_t)digit << (8 * i);
+	}
+	return 0;
+}
+
+/**
+ * @internal
+ * Reads @p len bytes stored as they are in @p buf. They start at the byte
+ * boundary after the last code: the codes read past it, in @p b or @p q,
+ * are given back or copied first.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int get_bytes(struct bitio* f, struct code_block* b, struct code_batch* q, uint8_t* buf, size_t len) {
+
+	size_t n = 0;
+
+	if (b != NULL) {
+		n = b->len - b->pos < len ? b->len - b->pos : len;
+		memcpy(buf, b->buf + b->pos, n);
+		b->pos += n;
+	}
+	else {
+		if (q->pos < q->n && bitio_unread(f, (uint64_t)(q->n - q->pos) * q->bits) < 0)
+			return -1;
+		q->pos = q->n = 0;
+		if (bitio_align(f) < 0)
+			return -1;
+	}
+	if (n < len && bitio_read_bytes(f, buf + n, len - n) != len - n)
+		return -1;
+	return 0;
+}
+
+/**
+ * @internal
+ * Writes a run of @p len bytes @p v on @p f after the @p *out_len bytes of
+ * @p out_buf, through @p out_buf. A run of zeros at least @c OUT_BLOCK long is
+ * skipped with a seek if @p *seek is set, leaving a hole: @p *seek is then
+ * set to @c 2, and to @c 0 if @p f cannot seek.
+ *
+ *	@return	@c 0 on success, @c -1 otherwise.
+ */
+static int out_run(FILE* f, uint8_t* out_buf, size_t* out_len, uint8_t v, uint64_t len, int* seek, EVP_MD_CTX* md_ctx) {
+
+	size_t n;
+
+	if (v == 0 && len >= OUT_BLOCK && *seek) {
+		if (out_write(f, out_buf, *out_len, md_ctx) < 0)
+			return -1;
+		*out_len = 0;
+		if (fseeko(f, len, SEEK_CUR) == 0) {
+			*seek = 2;
+			if (md_ctx != NULL) { // the digest still needs the zeros
+				memset(out_buf, 0, OUT_BLOCK);
+				for (; len != 0; len -= n) {
+					n = len < OUT_BLOCK ? len : OUT_BLOCK;
+					EVP_DigestUpdate(md_ctx, out_buf, n);
+				}
+			}
+			return 0;
+		}
+		*seek = 0;
+	}
+
+	for (; len != 0; len -= n) {
+		if (*out_len == OUT_BLOCK) {
+			if (out_write(f, out_buf, *out_len, md_ctx) < 0)
+				return -1;
+			*out_len = 0;
+		}
+		n = len < OUT_BLOCK - *out_len ? len : OUT_BLOCK - *out_len;
+		memset(out_buf + *out_len, v, n);
+		*out_len += n;
+	}
+	return 0;
+}
+
+int64_t decompress(const char* in_filename, const char* out_filename, uint8_t flags, const struct dictfile* df, uint64_t max_memory) {
 
 	struct bitio		*bd = bstdin;
 	struct dictionary	*d = NULL;
+	struct code_block	*cb = NULL;
+	struct code_batch	*cq = NULL;
+	uint8_t				*out_buf = NULL;
+	size_t				out_len = 0;
+	struct entropy		*ec = NULL;
 	struct utimbuf		*t = NULL;
+	struct stat			in_stat, out_stat;
 	FILE*				fout = stdout;
 	char				*out_file = NULL;
-	uint8_t				bits, initial_bits, meta_type, meta_size;
-	uint16_t			c;
-	uint32_t			bitMask, cur, first_record, len, next_record, dict_size = 0, written = 0, write_count = 0;
-	uint64_t			filesize = 0;
+	uint8_t				bits, initial_bits, meta_type, meta_size, ctrl_codes = 0, reset_policy = RESET_POLICY_RESET, growth = GROWTH_LZW, entropy = ENTROPY_NONE;
+	uint32_t			cur, n, first_record, len, next_record, prev = ROOT_NODE, dict_size = 0, resets = 0;
+	uint64_t			filesize = 0, dict_id = 0, needed, bitMask, write_count = 0;
 	char				*word;
-	int					first = 1, md5c_size = 0, md5d_size = 0;
+	int					first = 1, primed = 0, seek = 0, md5c_size = 0, md5d_size = 0, err;
 	void				*meta_data, *md5c = NULL, *md5d = NULL;
 	EVP_MD_CTX			*md_ctx = NULL;
 
+	phase_enter(PHASE_META);
 	if (in_filename != NULL) { 
 		bd = bitio_open(in_filename, 'r');
 		if (bd == NULL)
@@ -72,6 +307,39 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 				PRINT(1, "Dictionary Size:\t%d\n", dict_size);
 				break;
 
+			case META_CTRL_CODES:
+				ctrl_codes = *(uint8_t*)meta_data;
+				break;
+
+			case META_RESET_POLICY:
+				reset_policy = *(uint8_t*)meta_data;
+				PRINT(1, "Reset Policy:\t\t%s\n", reset_policy_name(reset_policy));
+				break;
+
+			case META_GROWTH:
+				growth = *(uint8_t*)meta_data;
+				PRINT(1, "Dictionary Growth:\t%s\n", growth_name(growth));
+				break;
+
+			case META_ENTROPY:
+				entropy = *(uint8_t*)meta_data;
+				PRINT(1, "Entropy Coding:\t\t%s\n", entropy == ENTROPY_RANGE ? "Range" : entropy == ENTROPY_BYTES ? "Bytes" : "Unknown");
+				break;
+
+			case META_DICT_ID:
+				dict_id = *(uint64_t*)meta_data;
+				primed = 1;
+				PRINT(1, "Dictionary File:\t%016llx\n", (unsigned long long)dict_id);
+				break;
+
+			case META_MAX_MEMORY:
+				PRINT(1, "Memory Budget:\t\t%.3f MB\n", (double)*(uint64_t*)meta_data/(1024*1024));
+				break;
+
+			case META_HT_SIZE:
+				PRINT(1, "Hash Table Size:\t%u\n", *(uint32_t*)meta_data);
+				break;
+
 			case META_NAME:
 				PRINT(1, "Original file name:\t%s\n", (char*)meta_data);
 				if (flags & DEC_ORIG_FILENAME) {
@@ -116,6 +384,14 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 	if ((flags & DEC_ORIG_FILENAME) && out_file == NULL) // if i have DEC_ORIG_FILENAME setted but no info in metadata i use stdin as outfile
 		out_filename = "stdin";
 	
+	// refuse before creating the output a stream that needs more memory than allowed
+	needed = memlimit_needed(dict_size, 0, 0, growth, reset_policy == RESET_POLICY_RECYCLE, primed && df != NULL ? dictfile_memory(df) : 0);
+	if (max_memory != 0 && needed > max_memory) {
+		PRINT(0, "Stream needs %.3f MB of memory, more than the %.3f MB allowed\n", (double)needed/(1024*1024), (double)max_memory/(1024*1024));
+		errno = ENOMEM;
+		goto error;
+	}
+
 	if (out_filename != NULL) {
 		fout = fopen(out_filename, "w");
 		if (fout == NULL)
@@ -127,15 +403,47 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 		goto error;
 	}
 
+	// runs of zeros are left as holes in a regular file, unless every write appends
+	seek = fstat(fileno(fout), &out_stat) == 0 && S_ISREG(out_stat.st_mode) && !(fcntl(fileno(fout), F_GETFL) & O_APPEND);
+
 	if (dict_size == 0)
 		goto error;
 
-	d = dict_new(dict_size, 0, dict_size, NUM_SYMBOLS);
+	if (growth > GROWTH_LZMW || entropy > ENTROPY_BYTES || (entropy == ENTROPY_BYTES && dict_size > ENTROPY_BYTES_MAX_SIZE) || (growth != GROWTH_LZW && reset_policy == RESET_POLICY_RECYCLE)) {
+		errno = EINVAL;
+		goto error;
+	}
+
+	// the stream was compressed with a dictionary file: it must be the same one
+	if (primed && (df == NULL || dictfile_id(df) != dict_id)) {
+		PRINT(1, "Dictionary file %016llx needed\n", (unsigned long long)dict_id);
+		errno = EINVAL;
+		goto error;
+	}
+
+	// with growths other than LZW the compressor's dictionary is rebuilt, to
+	// know which phrases it added
+	phase_enter(PHASE_DICT);
+	if (growth == GROWTH_LZW)
+		d = dict_new(dict_size, 0, dict_size, NUM_SYMBOLS);
+	else
+		d = dict_new(dict_size, 1, dict_ht_size(dict_size, NUM_SYMBOLS), NUM_SYMBOLS);
 
 	if (d == NULL)
 		goto error;
 
-	first_record = dict_init(d);
+	if (growth != GROWTH_LZW && dict_set_growth(d, growth) < 0)
+		goto error;
+
+	if (reset_policy == RESET_POLICY_RECYCLE && dict_track_uses(d) < 0)
+		goto error;
+
+	first_record = dict_init(d) + ctrl_codes;
+	if (primed) {
+		first_record = dict_set_base(d, dictfile_dict(df), first_record);
+		if (first_record == 0)
+			goto error;
+	}
 	next_record = first_record;
 	initial_bits = 0;
 	bitMask = 1;
@@ -144,74 +452,267 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 		initial_bits++;
 	}
 	bits = initial_bits;
-	
+
+	if (entropy == ENTROPY_RANGE) {
+		ec = entropy_new(bd, 0, NUM_SYMBOLS + 1 + ctrl_codes);
+		if (ec == NULL)
+			goto error;
+	}
+	else if (entropy == ENTROPY_BYTES) {
+		cb = malloc(sizeof(*cb));
+		if (cb == NULL)
+			goto error;
+		cb->width = ENTROPY_BYTES_WIDTH(dict_size);
+		cb->mask = ((uint32_t)1 << (8 * cb->width)) - 1;
+		cb->pos = 0;
+		cb->len = 0;
+	}
+	else {
+		cq = malloc(sizeof(*cq));
+		if (cq == NULL)
+			goto error;
+		cq->pos = 0;
+		cq->n = 0;
+	}
+
+	out_buf = malloc(OUT_BLOCK);
+	if (out_buf == NULL)
+		goto error;
+
+	// the size of the stream is known only if it is a regular file
+	if ((in_filename != NULL ? stat(in_filename, &in_stat) : fstat(STDIN_FILENO, &in_stat)) == 0 && S_ISREG(in_stat.st_mode))
+		telemetry_start("decompress", in_stat.st_size);
+	else
+		telemetry_start("decompress", 0);
+
+	phase_enter(PHASE_LOOP);
+	PROBE3(block_start, 1, bitio_bytes(bd), filesize);
 	for (;;) {
 		// put in cur the index of the fetched word in the dictionary
-		cur = fetch(bd, bits);
+		// valid codes are the records, and the one pending for the compressor
+		n = next_record + !first < dict_size ? next_record + !first : dict_size;
+		cur = get(bd, ec, cb, cq, bits, n);
 		if (cur == ROOT_NODE)
 			goto error;
 
 		if (cur == EOF_SYMBOL)
 			break;
 
-		c = dict_first_symbol(d, cur);
-		
-		if (c == EOF_SYMBOL)
-			goto error;
-		
-		if (!first) {
-			// complete previous record with index of new record
-			// ROOT_NODE as current node value means 'don't change it'.
-			dict_fill(d, next_record, ROOT_NODE, (uint8_t) c, 0);
-			next_record++;
-			if ((next_record+1) & bitMask) {
-				bitMask <<= 1;
-				bits++;
+		if (cur == RUN_SYMBOL && ctrl_codes >= RUN_SYMBOL - EOF_SYMBOL) { // byte, length
+			uint32_t	v = get(bd, ec, cb, cq, bits, n);
+			uint64_t	run_len;
+
+			if (growth != GROWTH_LZW || v >= NUM_SYMBOLS || get_length(bd, ec, cb, cq, bits, n, &run_len) < 0) {
+				errno = EINVAL;
+				goto error;
 			}
+			LOG("Run of %llu bytes %u", (unsigned long long)run_len, v);
+
+			// the compressor added the pending record with the byte, and starts a new phrase
+			if (!first && next_record < dict_size) {
+				dict_fill(d, next_record, ROOT_NODE, (uint8_t) v, 0);
+				next_record++;
+			}
+			first = 1;
+			STATS_PHRASE(run_len);
+
+			if (out_run(fout, out_buf, &out_len, v, run_len, &seek, md5c != NULL ? md_ctx : NULL) < 0)
+				goto error;
+			progress(bd, &filesize, &write_count, run_len, resets);
+			continue;
 		}
-		else
-			first = 0;
+
+		if (cur == STORED_SYMBOL && ctrl_codes >= STORED_SYMBOL - EOF_SYMBOL) { // length, bytes
+			uint64_t	stored_len, left;
+			size_t		k;
+
+			if (growth != GROWTH_LZW || ec != NULL || get_length(bd, ec, cb, cq, bits, n, &stored_len) < 0) {
+				errno = EINVAL;
+				goto error;
+			}
+			LOG("Stored %llu bytes", (unsigned long long)stored_len);
+
+			// the bytes go straight in the output block
+			for (left = stored_len; left != 0; left -= k) {
+				if (out_len == OUT_BLOCK) {
+					if (out_write(fout, out_buf, out_len, md5c != NULL ? md_ctx : NULL) < 0)
+						goto error;
+					out_len = 0;
+				}
+				k = left < OUT_BLOCK - out_len ? left : OUT_BLOCK - out_len;
+				if (get_bytes(bd, cb, cq, out_buf + out_len, k) < 0) {
+					errno = EINVAL;
+					goto error;
+				}
+
+				// the compressor added the pending record with the first byte, and starts a new phrase
+				if (left == stored_len && !first && next_record < dict_size) {
+					dict_fill(d, next_record, ROOT_NODE, out_buf[out_len], 0);
+					next_record++;
+				}
+				out_len += k;
+			}
+			first = 1;
+			STATS_PHRASE(stored_len);
+
+			progress(bd, &filesize, &write_count, stored_len, resets);
+			continue;
+		}
+
+		if (cur > EOF_SYMBOL && cur <= EOF_SYMBOL + ctrl_codes) { // control code
+			if (cur != RESET_SYMBOL) {
+				LOG("Unknown control code %u", cur);
+				errno = EINVAL;
+				goto error;
+			}
+
+			phase_enter(PHASE_RESET);
+			PROBE4(dict_reset, 1, filesize + write_count, next_record, bits);
+			resets++;
+			if (growth != GROWTH_LZW)
+				dict_reinit(d);
+			else
+				STATS_RESET(next_record - first_record, dict_size - first_record);
+			next_record = first_record;
+			bits = initial_bits;
+			bitMask = (uint64_t)1 << bits;
+			prev = ROOT_NODE;
+			first = 1;
+			phase_enter(PHASE_LOOP);
+			continue;
+		}
+
+		// phrases are added after being emitted: there is no pending record
+		if (growth != GROWTH_LZW && cur >= next_record) {
+			errno = EINVAL;
+			goto error;
+		}
+
+		dict_use(d, cur);
 
 		// get the word in the dictionary at index cur.
 		word = dict_word(d, cur, &len);
 		if (word == NULL)
 			goto error;
-		
-		written = fwrite(word, 1, len, fout);
 
-		if (written < len)
-			goto error;
-		else { // md5 computation and visual feedback
+		if (growth == GROWTH_LZW) {
+			if (!first && next_record < dict_size) {
+				// complete previous record with the first symbol of the word:
+				// if the word is that record, its last symbol is the first one
+				// ROOT_NODE as current node value means 'don't change it'.
+				dict_fill(d, next_record, ROOT_NODE, (uint8_t) word[0], 0);
+				if (cur == next_record)
+					word[len-1] = word[0];
+				next_record++;
+			}
+			else
+				first = 0;
 
-			if (md5c != NULL) // compute md5 of decompressed
-				EVP_DigestUpdate(md_ctx, word, len);
+			if (next_record < dict_size && ((next_record+1) & bitMask)) {
+				bitMask <<= 1;
+				bits++;
+			}
+		}
+
+		STATS_PHRASE(len);
 
-			write_count += written;
-			if (write_count >= COUNT_THRESHOLD) {
-				filesize += write_count;
-				write_count = 0;
-				PRINT(1, ".");
+		// words are gathered in a block: one write and one md5 update per block
+		if (out_len + len > OUT_BLOCK) {
+			if (out_write(fout, out_buf, out_len, md5c != NULL ? md_ctx : NULL) < 0)
+				goto error;
+			out_len = 0;
+		}
+		if (len > OUT_BLOCK) {
+			if (out_write(fout, word, len, md5c != NULL ? md_ctx : NULL) < 0)
+				goto error;
+		}
+		else {
+			memcpy(out_buf + out_len, word, len);
+			out_len += len;
+		}
+
+		// visual feedback
+		progress(bd, &filesize, &write_count, len, resets);
+
+		if (growth != GROWTH_LZW) {
+			// same steps as the compressor after emitting cur
+			if (next_record < dict_size) {
+				if (prev != ROOT_NODE) {
+					next_record = dict_grow(d, prev, (uint8_t*)word, len, next_record);
+					if (next_record == 0)
+						goto error;
+					while (bitMask < next_record) {
+						bitMask <<= 1;
+						bits++;
+					}
+				}
+				prev = cur;
+
+				if (next_record == dict_size && reset_policy == RESET_POLICY_RESET) {
+					phase_enter(PHASE_RESET);
+					PROBE4(dict_reset, 1, filesize + write_count, next_record, bits);
+					resets++;
+					dict_reinit(d);
+					next_record = first_record;
+					bits = initial_bits;
+					bitMask = (uint64_t)1 << bits;
+					prev = ROOT_NODE;
+					phase_enter(PHASE_LOOP);
+				}
 			}
+			continue;
 		}
 
-		if (next_record + 1 == dict_size) {
-			
+		if (next_record + 1 == dict_size && reset_policy == RESET_POLICY_RESET) {
+
+			phase_enter(PHASE_RESET);
+			PROBE4(dict_reset, 1, filesize + write_count, next_record, bits);
+			resets++;
+			STATS_RESET(next_record - first_record, dict_size - first_record);
 			next_record = first_record;
 			
 			bits = initial_bits;
-			bitMask = 1 << bits;
+			bitMask = (uint64_t)1 << bits;
 
 			first = 1; // set first iteration to be the next
+			phase_enter(PHASE_LOOP);
+		}
+		else if (next_record + 1 == dict_size && reset_policy == RESET_POLICY_RECYCLE) {
+
+			// record dict_size-1 is never used: the compressor recycled it right away
+			phase_enter(PHASE_RESET);
+			PROBE4(dict_reset, 1, filesize + write_count, next_record, bits);
+			resets++;
+			STATS_RESET(next_record - first_record, dict_size - first_record);
+			next_record = dict_recycle(d, first_record, next_record, (dict_size - first_record) / 2);
+			if (next_record == 0)
+				goto error;
+
+			bits = initial_bits;
+			bitMask = (uint64_t)1 << bits;
+			while (bitMask < next_record) {
+				bitMask <<= 1;
+				bits++;
+			}
+
+			first = 1;
+			phase_enter(PHASE_LOOP);
 		}
 
-		// add a new record
-		dict_fill(d, next_record, cur, 0, 0); // symbol will be filled at the beginning of next iteration
+		// add a new record, unless the dictionary is frozen
+		if (next_record < dict_size)
+			dict_fill(d, next_record, cur, 0, 0); // symbol will be filled at the beginning of next iteration
 
 	}
-	
+
+	if (out_write(fout, out_buf, out_len, md5c != NULL ? md_ctx : NULL) < 0)
+		goto error;
 	filesize += write_count;
+	PROBE3(block_end, 1, bitio_bytes(bd), filesize);
+	telemetry_end(bitio_bytes(bd), filesize, resets);
 
 	if (md5c != NULL) {
+		phase_enter(PHASE_DIGEST);
 		EVP_DigestFinal_ex(md_ctx, md5d, (unsigned int*)&md5d_size);
 
 		if (md5c_size == md5d_size && memcmp(md5c, md5d, md5c_size) == 0)
@@ -224,6 +725,11 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 
 	PRINT(1, "\nDecompression Finished\n\n");
 
+	phase_enter(PHASE_FLUSH);
+	fflush(fout);
+	if (seek == 2 && ftruncate(fileno(fout), ftello(fout)) < 0) // a hole at the end has no bytes to write
+		goto error;
+	phase_enter(PHASE_CLOSE);
 	fclose(fout);
 	if (out_file != NULL && t != NULL)
 		if (utime(out_filename, t) < 0) { // set modification time
@@ -231,23 +737,35 @@ int64_t decompress(const char* in_filename, const char* out_filename, uint8_t fl
 		}
 	free(out_file);
 	free(t);
+	free(cb);
+	free(cq);
+	free(out_buf);
+	entropy_delete(ec);
 	dict_delete(d);
 	bitio_flush(bd);
 	if (bd != bstdin)
 		bitio_close(bd);
+	phase_enter(PHASE_NONE);
 	return filesize;
 
 error:
+	err = errno; // the cleanup must not hide the cause
+	phase_enter(PHASE_NONE);
 	PRINT(1, "\n");
-	if (out_filename != NULL)
+	if (out_filename != NULL && fout != NULL) // only an output this run created
 		unlink(out_filename);
 	free(out_file);
 	free(t);
+	free(cb);
+	free(cq);
+	free(out_buf);
+	entropy_delete(ec);
 	dict_delete(d);
 	bitio_flush(bd);
 	if (bd != bstdin)
 		bitio_close(bd);
 	if (fout != NULL)
 		fclose(fout);
+	errno = err;
 	return -1;
 }
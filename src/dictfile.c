@@ -0,0 +1,289 @@
+/**
+ * @file	dictfile.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for trained dictionary files, used to prime the dictionary.
+ * @internal
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "debug.h"
+#include "dictfile.h"
+#include "dictionary.h"
+#include "verbose.h"
+
+#define DICTFILE_MAGIC		"LZ78DICT"	/**< First bytes of a dictionary file. */
+#define DICTFILE_VERSION	1			/**< Version of the format, in host byte order. */
+#define TRAIN_FACTOR		4			/**< Size of the training dictionary, in trained dictionaries. */
+
+/**
+ * Header of a dictionary file, followed by the parents and the symbols.
+ * @internal
+ */
+struct dictfile_header {
+	char		magic[8];		/**< DICTFILE_MAGIC, without '\0'. */
+	uint32_t	version;		/**< DICTFILE_VERSION: a different byte order does not match. */
+	uint32_t	symbols;		/**< Size of the alphabet. */
+	uint32_t	first_record;	/**< Index of the first record. */
+	uint32_t	records;		/**< Number of records. */
+	uint64_t	id;				/**< Hash of the fields above and of the records. */
+};
+
+/**
+ * Structure of the dictionary file context.
+ * @internal
+ */
+struct dictfile {
+	void				*map;		/**< Mapped file. */
+	size_t				map_size;	/**< Size of the mapped file. */
+	uint64_t			id;			/**< Identifier of the dictionary file. */
+	uint32_t			first_record;	/**< Index of the first record. */
+	uint32_t			records;	/**< Number of records. */
+	struct dictionary	*dict;		/**< Read-only dictionary of the records. */
+};
+
+/**
+ * Adds @p len bytes from @p buf to the FNV-1a hash @p h and returns it.
+ * @internal
+ */
+static uint64_t fnv1a(uint64_t h, const void* buf, size_t len) {
+
+	const uint8_t *p = buf;
+
+	while (len-- > 0)
+		h = (h ^ *p++) * 0x100000001B3ULL;
+	return h;
+}
+
+/**
+ * Returns the identifier of a dictionary file with header @p h and records
+ * @p parent and @p symbol.
+ * @internal
+ */
+static uint64_t dictfile_hash(const struct dictfile_header* h, const uint32_t* parent, const uint8_t* symbol) {
+
+	uint64_t id = 0xCBF29CE484222325ULL;
+
+	id = fnv1a(id, &h->symbols, sizeof(h->symbols));
+	id = fnv1a(id, &h->first_record, sizeof(h->first_record));
+	id = fnv1a(id, &h->records, sizeof(h->records));
+	id = fnv1a(id, parent, sizeof(*parent) * h->records);
+	id = fnv1a(id, symbol, sizeof(*symbol) * h->records);
+	return id;
+}
+
+int64_t dictfile_train(const char* out_filename, char* const* in_filenames, int count, uint32_t records) {
+
+	struct dictionary		*d = NULL;
+	struct dictfile_header	h;
+	FILE					*fin = NULL, *fout = NULL;
+	int						c, i;
+	uint32_t				cur, y, first_record, next_record, size, *parent = NULL;
+	uint8_t					*symbol = NULL;
+	uint64_t				samples = 0;
+
+	if (out_filename == NULL || records == 0 || (in_filenames == NULL && count > 0)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	size = (uint64_t)records * TRAIN_FACTOR + NUM_SYMBOLS + 1 + CTRL_CODES < DICT_MAX_SIZE ?
+			records * TRAIN_FACTOR + NUM_SYMBOLS + 1 + CTRL_CODES : DICT_MAX_SIZE;
+	d = dict_new(size, 1, dict_ht_size(size, NUM_SYMBOLS), NUM_SYMBOLS);
+	if (d == NULL || dict_track_uses(d) < 0)
+		goto error;
+
+	// keep the control codes of this version free, whatever the policy of the streams
+	first_record = dict_init(d) + CTRL_CODES;
+	next_record = first_record;
+
+	// compress the samples with the recycle policy, without writing anything
+	for (i = 0; i == 0 || i < count; i++) {
+		fin = count > 0 ? fopen(in_filenames[i], "r") : stdin;
+		if (fin == NULL)
+			goto error;
+
+		cur = ROOT_NODE;
+		while ((c = getc(fin)) != EOF) {
+			samples++;
+			if (dict_lookup(d, cur, c, &y)) {
+				cur = dict_next(d, y);
+				continue;
+			}
+
+			dict_use(d, cur);
+			if (!dict_fill(d, y, cur, c, next_record++))
+				goto error;
+			if (next_record == size) {
+				next_record = dict_recycle(d, first_record, next_record, (size - first_record) / 2);
+				if (next_record == 0)
+					goto error;
+			}
+
+			dict_lookup(d, ROOT_NODE, c, &y);
+			cur = dict_next(d, y);
+		}
+		if (ferror(fin))
+			goto error;
+		if (cur != ROOT_NODE)
+			dict_use(d, cur);
+
+		if (fin != stdin)
+			fclose(fin);
+		fin = NULL;
+	}
+
+	// keep the most used records
+	next_record = dict_recycle(d, first_record, next_record, records);
+	if (next_record == 0)
+		goto error;
+
+	memcpy(h.magic, DICTFILE_MAGIC, sizeof(h.magic));
+	h.version = DICTFILE_VERSION;
+	h.symbols = NUM_SYMBOLS;
+	h.first_record = first_record;
+	h.records = next_record - first_record;
+
+	parent = malloc(sizeof(*parent) * (h.records + 1));
+	symbol = malloc(sizeof(*symbol) * (h.records + 1));
+	if (parent == NULL || symbol == NULL)
+		goto error;
+	if (dict_records(d, first_record, next_record, parent, symbol) < 0)
+		goto error;
+	h.id = dictfile_hash(&h, parent, symbol);
+
+	fout = fopen(out_filename, "w");
+	if (fout == NULL)
+		goto error;
+	if (fwrite(&h, sizeof(h), 1, fout) != 1
+			|| fwrite(parent, sizeof(*parent), h.records, fout) != h.records
+			|| fwrite(symbol, sizeof(*symbol), h.records, fout) != h.records)
+		goto error;
+	if (fclose(fout) != 0) {
+		fout = NULL;
+		goto error;
+	}
+
+	PRINT(1, "Trained Records:\t%u from %llu bytes\n", h.records, (unsigned long long)samples);
+	PRINT(1, "Dictionary ID:\t\t%016llx\n", (unsigned long long)h.id);
+
+	free(parent);
+	free(symbol);
+	dict_delete(d);
+	return h.records;
+
+error:
+	if (fin != NULL && fin != stdin)
+		fclose(fin);
+	if (fout != NULL) {
+		fclose(fout);
+		unlink(out_filename);
+	}
+	free(parent);
+	free(symbol);
+	dict_delete(d);
+	return -1;
+}
+
+struct dictfile* dictfile_open(const char* filename) {
+
+	struct dictfile			*df = NULL;
+	struct stat				file_stat;
+	const struct dictfile_header	*h;
+	const uint32_t			*parent;
+	const uint8_t			*symbol;
+	int						fd;
+
+	if (filename == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	df = malloc(sizeof(*df));
+	if (df == NULL)
+		return NULL;
+	df->map = MAP_FAILED;
+	df->dict = NULL;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		goto error;
+	if (fstat(fd, &file_stat) < 0 || file_stat.st_size < sizeof(*h)) {
+		close(fd);
+		errno = EINVAL;
+		goto error;
+	}
+	df->map_size = file_stat.st_size;
+	df->map = mmap(NULL, df->map_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (df->map == MAP_FAILED)
+		goto error;
+
+	h = df->map;
+	parent = (const uint32_t*)(h + 1);
+	symbol = (const uint8_t*)(parent + h->records);
+	if (memcmp(h->magic, DICTFILE_MAGIC, sizeof(h->magic)) != 0 || h->version != DICTFILE_VERSION
+			|| h->symbols != NUM_SYMBOLS || df->map_size != sizeof(*h) + (uint64_t)h->records * (sizeof(*parent) + sizeof(*symbol))
+			|| h->id != dictfile_hash(h, parent, symbol)) {
+		LOG("Invalid dictionary file %s", filename);
+		errno = EINVAL;
+		goto error;
+	}
+
+	df->id = h->id;
+	df->first_record = h->first_record;
+	df->records = h->records;
+	df->dict = dict_new_base(h->symbols, h->first_record, h->records, parent, symbol);
+	if (df->dict == NULL)
+		goto error;
+
+	return df;
+
+error:
+	dictfile_close(df);
+	return NULL;
+}
+
+uint64_t dictfile_id(const struct dictfile* df) {
+
+	return df->id;
+}
+
+uint32_t dictfile_first_record(const struct dictfile* df) {
+
+	return df->first_record;
+}
+
+uint32_t dictfile_records(const struct dictfile* df) {
+
+	return df->records;
+}
+
+const struct dictionary* dictfile_dict(const struct dictfile* df) {
+
+	return df->dict;
+}
+
+uint64_t dictfile_memory(const struct dictfile* df) {
+
+	return df->map_size + dict_memory_usage(df->dict);
+}
+
+void dictfile_close(struct dictfile* df) {
+
+	if (df != NULL) {
+		dict_delete(df->dict);
+		if (df->map != MAP_FAILED)
+			munmap(df->map, df->map_size);
+		free(df);
+	}
+}
@@ -6,27 +6,61 @@
  * @internal
  */
 
+#include <endian.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "cpu.h"
 #include "debug.h"
 
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
 #include "dictionary.h"
+#include "stats.h"
 #include "verbose.h"
 
 #define WORD_START_SIZE	10
+#define HT_START_SIZE	4096	/**< Initial number of free records of a compression hash table. */
+#define HT_MAX_LOAD_NUM	3		/**< Numerator of the load factor that triggers a hash table growth. */
+#define HT_MAX_LOAD_DEN	4		/**< Denominator of the load factor that triggers a hash table growth. */
+#define PROBE_SCALAR	4		/**< Records the vector probes look at one at a time before they load vectors. */
+#define HOT_BITS		11		/**< Bits of the index of the hot record cache, whose 2^HOT_BITS records take 32 kB. */
+#define HOT_SIZE		(1U << HOT_BITS)	/**< Number of records of the hot record cache. */
+#define HOT_DEPTH		3		/**< Depth of the nodes whose children are no longer cached (root children have depth 1). */
+
+#define HT_EMPTY_KEY	((uint64_t)EMPTY_NODE << 8)	/**< Key of an empty record of the hash table. */
 
 /**
  * Type that represent the tree/hash table.
  * @internal
  */
 struct ht_t {
-	uint32_t	*current;	/**< Index of starting node of the branch. */
-	uint8_t		*symbol;	/**< Symbol correspondent to the branch. */
+	uint64_t	*key;		/**< Index of starting node of the branch and symbol correspondent to it (see ht_key()). */
 	uint32_t	*next;		/**< Index of ending node of the branch. */
 };
 
+/**
+ * Record of the hot record cache: a copy of a record of the hash table
+ * followed by a recent dict_match() kernel.
+ * @internal
+ */
+struct hot_t {
+	uint64_t	key;		/**< Key of the record (see ht_key()), HT_EMPTY_KEY if none. */
+	uint32_t	next;		/**< Index of ending node of the branch. */
+};
+
+/**
+ * Type of the probes of the hash table: from record @p j, each one returns
+ * the first record of the probe sequence of @p key that either holds @p k or
+ * is empty. Records wrap around from (@p ht_size - 1) to @p first.
+ * @internal
+ */
+typedef uint32_t (*probe_fn)(const uint64_t* key, uint32_t j, uint32_t first, uint32_t ht_size, uint64_t k);
+
 /**
  * Structure of the dictionary context.
  * @internal
@@ -34,17 +68,34 @@ struct ht_t {
 struct dictionary {
 	uint32_t		size;			/**< Maximum number of nodes (words) in the dictionary tree. */
 	uint16_t		symbols;		/**< Size of the alphabet. */
-	struct ht_t		ht;				/**< Structure that contains the hash table. */
-	uint32_t		ht_size;		/**< Size of the hash table, in number of records. */
+	struct ht_t		ht;				/**< Structure that contains the hash table (compression only). */
+	probe_fn		probe;			/**< Probe of the hash table for the CPU level (see cpu_level()). */
+	struct hot_t	*hot;			/**< Direct-mapped cache of the records near the root followed last by dict_match(), HOT_SIZE records (NULL if none). */
+	uint8_t			*packed;		/**< Records of a decompression dictionary, pack_bits bits each (see packed_get()). */
+	uint8_t			pack_bits;		/**< Bits of a packed record: enough for (parent + 1) and 8 for the symbol. */
+	uint64_t		pack_mask;		/**< Mask of the pack_bits low bits. */
+	uint32_t		ht_size;		/**< Current size of the hash table, in number of records. */
+	uint32_t		ht_max_size;	/**< Size the hash table is allowed to grow up to, in number of records. */
+	uint32_t		ht_count;		/**< Number of records filled since last (re)initialization. */
+	uint32_t		ht_grow_at;		/**< Value of ht_count after which the hash table is grown. */
+	uint16_t		*uses;			/**< Usage counter of each record, indexed by node (NULL if not tracked). */
+	uint8_t			growth;			/**< How the dictionary grows, one of the @c GROWTH_* values. */
+	uint32_t		inner;			/**< Number of intermediate nodes allowed (GROWTH_LZMW only). */
+	uint32_t		inner_count;	/**< Number of intermediate nodes used since last (re)initialization. */
+	uint32_t		*slot;			/**< Hash table slot of each node (NULL if not tracked). */
+	const struct dictionary	*base;	/**< Read-only dictionary holding the records below base->size (NULL if none). */
+	uint32_t		rec_first;		/**< Index of the first record listed in rec_current and rec_symbol (base only). */
+	const uint32_t	*rec_current;	/**< Parent of each record from rec_first on, not owned (base only). */
+	const uint8_t	*rec_symbol;	/**< Symbol of each record from rec_first on, not owned (base only). */
 	char			*word;			/**< Pointer to auxiliary memory used by dict_word() function. */
-	int				max_size;		/**< Current size of the memory pointend by word. */
+	uint32_t		max_size;		/**< Current size of the memory pointend by word. */
 	uint8_t			compression; 	/**< Indicates if the dictionary is used for compression or decompression. */
 };
 
 /**
  * Hash function: returns a value between @p min and (@p max - 1).
- * It uses Division Hash Function: H(x) = x mod m. 
- * (@p current || @p symbol) is used as key.
+ * (@p current || @p symbol) is used as a 64-bit key, so that nodes above
+ * 2^24 keep all their bits, and spread by a multiplicative hash.
  *
  *	@param	current	first part of the key
  *	@param	symbol	second part of the key
@@ -52,11 +103,373 @@ struct dictionary {
  *	@param	max		max return value plus one
  *
  *	@return	Hash of the key between min ad (max - 1)
- *	@internal Knuth division hash algorithm, using as key
- *	((@p current << 8) | @p symbol ).
+ *	@internal Fibonacci hashing of the key ((@p current << 8) | @p symbol):
+ *	its top 32 bits are scaled to (@p max - @p min) with a multiplication
+ *	instead of a division. A division hash of consecutive nodes fills runs
+ *	of consecutive records, and probe sequences grow along them.
+ */
+static inline uint32_t dict_hash(uint32_t current, uint32_t symbol, uint32_t min, uint32_t max) {
+
+	uint64_t key = ((uint64_t)current << 8 | symbol) * 0x9E3779B97F4A7C15ULL;
+
+	return min + (uint32_t)(((key >> 32) * (max - min)) >> 32);
+}
+
+/**
+ * Returns the key of a record of the hash table: (@p current << 8) | @p symbol,
+ * at most 40 bits, so that a probe compares one word per record.
+ * @internal
+ */
+static inline uint64_t ht_key(uint32_t current, uint8_t symbol) {
+
+	return (uint64_t)current << 8 | symbol;
+}
+
+/**
+ * Returns the starting node of key @p k.
+ * @internal
+ */
+static inline uint32_t key_current(uint64_t k) {
+
+	return (uint32_t)(k >> 8);
+}
+
+/**
+ * Returns the record of the hot record cache for key @p k.
+ * @internal
+ */
+static inline uint32_t hot_index(uint64_t k) {
+
+	return (uint32_t)((k * 0x9E3779B97F4A7C15ULL) >> (64 - HOT_BITS));
+}
+
+/**
+ * Empties the hot record cache of @p d, if any: to be done whenever records
+ * are removed from the hash table.
+ * @internal
+ */
+static void hot_clear(struct dictionary* d) {
+
+	uint32_t i;
+
+	for (i = 0; i < HOT_SIZE && d->hot != NULL; i++)
+		d->hot[i].key = HT_EMPTY_KEY;
+}
+
+#ifdef STATS
+/**
+ * Returns the number of records of the hash table of @p d skipped by a probe
+ * sequence for key (@p current, @p symbol) that ended at @p ht_index.
+ * It hashes the key again rather than counting the probes, so that the probe
+ * loop is the same with and without statistics.
+ * @internal
+ */
+static inline uint32_t probe_skipped(const struct dictionary* d, uint32_t current, uint32_t symbol, uint32_t ht_index) {
+
+	uint32_t start = dict_hash(current, symbol, d->symbols + 1, d->ht_size);
+
+	return ht_index >= start ? ht_index - start : ht_index + d->ht_size - start - d->symbols - 1;
+}
+#endif
+
+/**
+ * Returns the bytes needed to pack @p size records of @p bits bits each,
+ * plus the padding that lets packed_get() always load 8 bytes.
+ * @internal
+ */
+static inline uint64_t packed_bytes(uint32_t size, uint8_t bits) {
+
+	return ((uint64_t)size * bits + 7) / 8 + sizeof(uint64_t);
+}
+
+/**
+ * Returns the bits of a packed record of a dictionary of @p size records:
+ * the parent is stored plus one, so that ROOT_NODE wraps to 0 and the
+ * largest value is @p size.
+ * @internal
+ */
+static inline uint8_t packed_bits(uint32_t size) {
+
+	return 64 - __builtin_clzll(size) + 8;
+}
+
+/**
+ * Returns record @p i of the decompression dictionary @p d: (parent + 1) in
+ * the high bits and the symbol in the low 8 bits. A record is at most 40
+ * bits, so an unaligned 64-bit load always holds it.
+ * @internal
+ */
+static inline uint64_t packed_get(const struct dictionary* d, uint32_t i) {
+
+	uint64_t bit = (uint64_t)i * d->pack_bits, v;
+
+	memcpy(&v, d->packed + (bit >> 3), sizeof(v));
+	return (le64toh(v) >> (bit & 7)) & d->pack_mask;
+}
+
+/**
+ * Returns the parent of packed record @p v, ROOT_NODE if it has none.
+ * @internal
+ */
+static inline uint32_t packed_parent(uint64_t v) {
+
+	return (uint32_t)(v >> 8) - 1;
+}
+
+/**
+ * Stores @p parent and @p symbol in record @p i of the decompression
+ * dictionary @p d.
+ * @internal
+ */
+static inline void packed_set(struct dictionary* d, uint32_t i, uint32_t parent, uint8_t symbol) {
+
+	uint64_t bit = (uint64_t)i * d->pack_bits, v;
+	uint64_t mask = d->pack_mask << (bit & 7);
+
+	memcpy(&v, d->packed + (bit >> 3), sizeof(v));
+	v = (le64toh(v) & ~mask) | ((uint64_t)(uint32_t)(parent + 1) << 8 | symbol) << (bit & 7);
+	v = htole64(v);
+	memcpy(d->packed + (bit >> 3), &v, sizeof(v));
+}
+
+/**
+ * Probe of the generic kernels: one record at a time.
+ * @internal
+ */
+static inline uint32_t probe_generic(const uint64_t* key, uint32_t j, uint32_t first, uint32_t ht_size, uint64_t k) {
+
+	while (key[j] != k && key[j] != HT_EMPTY_KEY)
+		if (++j == ht_size)
+			j = first;
+
+	return j;
+}
+
+#ifdef CPU_X86
+/**
+ * Probe with SSE4.2: 2 records at a time, the last one of the table alone.
+ *
+ * Most probes end on their first record, and the vector probes would only
+ * load lines they do not need: they look at the first @c PROBE_SCALAR
+ * records one at a time, and load vectors for the clusters beyond.
+ * @internal
+ */
+static inline __attribute__((target("sse4.2"))) uint32_t probe_sse42(const uint64_t* key, uint32_t j, uint32_t first, uint32_t ht_size, uint64_t k) {
+
+	const __m128i	kk = _mm_set1_epi64x(k), e = _mm_set1_epi64x(HT_EMPTY_KEY);
+	__m128i			v;
+	uint32_t		i, m;
+
+	for (i = 0; i < PROBE_SCALAR; i++) {
+		if (key[j] == k || key[j] == HT_EMPTY_KEY)
+			return j;
+		if (++j == ht_size)
+			j = first;
+	}
+
+	for (;;) {
+		for (; j + 2 <= ht_size; j += 2) {
+			v = _mm_loadu_si128((const __m128i*)(key + j));
+			m = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_cmpeq_epi64(v, kk), _mm_cmpeq_epi64(v, e))));
+			if (m != 0)
+				return j + __builtin_ctz(m);
+		}
+		if (j < ht_size && (key[j] == k || key[j] == HT_EMPTY_KEY))
+			return j;
+		j = first;
+	}
+}
+
+/**
+ * Probe with AVX2: 4 records at a time, the last ones of the table one at
+ * a time.
+ * @internal
+ */
+static inline __attribute__((target("avx2"))) uint32_t probe_avx2(const uint64_t* key, uint32_t j, uint32_t first, uint32_t ht_size, uint64_t k) {
+
+	const __m256i	kk = _mm256_set1_epi64x(k), e = _mm256_set1_epi64x(HT_EMPTY_KEY);
+	__m256i			v;
+	uint32_t		i, m;
+
+	for (i = 0; i < PROBE_SCALAR; i++) {
+		if (key[j] == k || key[j] == HT_EMPTY_KEY)
+			return j;
+		if (++j == ht_size)
+			j = first;
+	}
+
+	for (;;) {
+		for (; j + 4 <= ht_size; j += 4) {
+			v = _mm256_loadu_si256((const __m256i*)(key + j));
+			m = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(v, kk), _mm256_cmpeq_epi64(v, e))));
+			if (m != 0)
+				return j + __builtin_ctz(m);
+		}
+		for (; j < ht_size; j++)
+			if (key[j] == k || key[j] == HT_EMPTY_KEY)
+				return j;
+		j = first;
+	}
+}
+
+/**
+ * Probe with AVX-512: 8 records at a time, compared into mask registers,
+ * the last ones of the table one at a time.
+ * @internal
+ */
+static inline __attribute__((target("avx512f,avx512bw"))) uint32_t probe_avx512(const uint64_t* key, uint32_t j, uint32_t first, uint32_t ht_size, uint64_t k) {
+
+	const __m512i	kk = _mm512_set1_epi64(k), e = _mm512_set1_epi64(HT_EMPTY_KEY);
+	__m512i			v;
+	__mmask8		m;
+	uint32_t		i;
+
+	for (i = 0; i < PROBE_SCALAR; i++) {
+		if (key[j] == k || key[j] == HT_EMPTY_KEY)
+			return j;
+		if (++j == ht_size)
+			j = first;
+	}
+
+	for (;;) {
+		for (; j + 8 <= ht_size; j += 8) {
+			v = _mm512_loadu_si512(key + j);
+			m = _mm512_cmpeq_epi64_mask(v, kk) | _mm512_cmpeq_epi64_mask(v, e);
+			if (m != 0)
+				return j + __builtin_ctz(m);
+		}
+		for (; j < ht_size; j++)
+			if (key[j] == k || key[j] == HT_EMPTY_KEY)
+				return j;
+		j = first;
+	}
+}
+#endif
+
+/**
+ * Probes of dict_lookup() by CPU level. The dict_match() kernels inline them
+ * instead.
+ * @internal
+ */
+static const probe_fn probes[CPU_LEVELS] = {
+	probe_generic,
+#ifdef CPU_X86
+	probe_sse42,
+	probe_avx2,
+	probe_avx512,
+#else
+	probe_generic,
+	probe_generic,
+	probe_generic,
+#endif
+};
+
+/**
+ * Allocates the arrays of hash table @p ht for @p ht_size records.
+ * The @c next array is allocated only if @p compression is set.
+ *
+ *	@return	@c 0 on success, @c -1 on failure (nothing is left allocated).
+ *	@internal
+ */
+static int ht_alloc(struct ht_t* ht, uint32_t ht_size, int compression) {
+
+	ht->key = malloc(sizeof(*ht->key)*ht_size);
+	ht->next = compression ? malloc(sizeof(*ht->next)*ht_size) : NULL;
+
+	if (ht->key == NULL || (compression && ht->next == NULL)) {
+		free(ht->key);
+		free(ht->next);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the smallest hash table size not lower than @p min_size such that
+ * (size - @p base) is a prime number, but never more than @p max_size.
+ * @internal
  */
-inline uint32_t dict_hash(uint32_t current, uint32_t symbol, uint32_t min, uint32_t max) {
-	return min + ((current << 8 | symbol) % (max - min));
+static uint32_t ht_next_size(uint64_t min_size, uint32_t base, uint32_t max_size) {
+
+	uint64_t n, i;
+
+	if (min_size >= max_size)
+		return max_size;
+
+	for (n = (min_size - base) | 1; n + base < max_size; n += 2) {
+		for (i = 3; i*i <= n && n % i != 0; i += 2);
+		if (i*i > n)
+			return n + base;
+	}
+
+	return max_size;
+}
+
+/**
+ * Sets the threshold of filled records after which the hash table of @p d grows.
+ * @internal
+ */
+static void ht_set_grow_at(struct dictionary* d) {
+
+	if (d->ht_size == d->ht_max_size)
+		d->ht_grow_at = UINT32_MAX; // never grow again, intermediate nodes included
+	else
+		d->ht_grow_at = (uint64_t)(d->ht_size - d->symbols - 1) * HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN;
+}
+
+/**
+ * Moves all the records of the hash table of @p d in a new hash table of
+ * @p ht_size records. Root children keep their positions.
+ * The records are moved all at once rather than a few at each insertion:
+ * the table at least doubles each time, so a record is moved about once
+ * on average, and lookups, dict_match() kernels and the slots of d->slot
+ * keep working on a single table.
+ *
+ *	@return	@c 0 on success, @c -1 on failure (the dictionary is left untouched).
+ *	@internal
+ */
+static int ht_rehash(struct dictionary* d, uint32_t ht_size) {
+
+	struct ht_t	new_ht;
+	uint32_t	i, j, base = d->symbols + 1;
+
+	if (ht_alloc(&new_ht, ht_size, 1) < 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for (i = 0; i < base; i++) {
+		new_ht.key[i] = d->ht.key[i];
+		new_ht.next[i] = d->ht.next[i];
+	}
+	for (; i < ht_size; i++)
+		new_ht.key[i] = HT_EMPTY_KEY;
+
+	for (i = base; i < d->ht_size; i++) {
+		if (d->ht.key[i] == HT_EMPTY_KEY)
+			continue;
+
+		j = dict_hash(key_current(d->ht.key[i]), (uint8_t)d->ht.key[i], base, ht_size);
+		while (new_ht.key[j] != HT_EMPTY_KEY)
+			if (++j == ht_size)
+				j = base;
+
+		new_ht.key[j] = d->ht.key[i];
+		new_ht.next[j] = d->ht.next[i];
+		if (d->slot != NULL)
+			d->slot[new_ht.next[j]] = j;
+	}
+
+	LOG("Hash table grown from %u to %u records", d->ht_size, ht_size);
+
+	free(d->ht.key);
+	free(d->ht.next);
+	d->ht = new_ht;
+	d->ht_size = ht_size;
+	ht_set_grow_at(d);
+
+	return 0;
 }
 
 struct dictionary* dict_new(uint32_t size, int compression, uint32_t ht_size, uint32_t symbols) {
@@ -71,28 +484,54 @@ struct dictionary* dict_new(uint32_t size, int compression, uint32_t ht_size, ui
 	d = malloc(sizeof(struct dictionary));
 	if(d == NULL)
 		return NULL;
-	d->ht.current = NULL;
-	d->ht.symbol = NULL;
+	d->ht.key = NULL;
 	d->ht.next = NULL;
+	d->probe = probes[cpu_level()];
+	d->hot = NULL;
+	d->packed = NULL;
+	d->pack_bits = 0;
+	d->pack_mask = 0;
+	d->uses = NULL;
+	d->slot = NULL;
+	d->base = NULL;
+	d->rec_first = 0;
+	d->rec_current = NULL;
+	d->rec_symbol = NULL;
 	d->word = NULL;
 	d->compression = compression;
+	d->growth = GROWTH_LZW;
+	d->inner = 0;
+	d->inner_count = 0;
 	
 	
 	d->size = size;
 	d->symbols = symbols;
-	
-	d->ht.current = malloc(sizeof(d->ht.current)*ht_size);
-	if (d->ht.current == NULL)
-		goto error;
-	d->ht.symbol = malloc(sizeof(d->ht.symbol)*ht_size);
-	if (d->ht.symbol == NULL)
-		goto error;
-	if (compression == 1) {
-		d->ht.next = malloc(sizeof(d->ht.next)*ht_size);
-		if (d->ht.next == NULL)
+	d->ht_max_size = ht_size;
+	d->ht_count = 0;
+
+	// the compressor starts with a small table and grows it on demand (see dict_fill)
+	if (compression)
+		ht_size = ht_next_size((uint64_t)symbols + 1 + HT_START_SIZE, symbols + 1, ht_size);
+
+	// the decompressor indexes its records by node: they are packed, zeroed so
+	// that a record not filled yet is a child of the root
+	if (compression) {
+		if (ht_alloc(&d->ht, ht_size, compression) < 0)
+			goto error;
+		d->hot = malloc(sizeof(*d->hot) * HOT_SIZE);
+		if (d->hot == NULL)
+			goto error;
+		hot_clear(d);
+	}
+	else {
+		d->pack_bits = packed_bits(size);
+		d->pack_mask = ((uint64_t)1 << d->pack_bits) - 1;
+		d->packed = calloc(packed_bytes(size, d->pack_bits), 1);
+		if (d->packed == NULL)
 			goto error;
 	}
 	d->ht_size = ht_size;
+	ht_set_grow_at(d);
 	
 	d->word = malloc(WORD_START_SIZE + 1);
 	if (d->word == NULL)
@@ -102,20 +541,142 @@ struct dictionary* dict_new(uint32_t size, int compression, uint32_t ht_size, ui
 	return d;
 
 error:
-	free(d->ht.current);
-	free(d->ht.symbol);
+	free(d->ht.key);
 	free(d->ht.next);
+	free(d->hot);
+	free(d->packed);
 	free(d->word);
 	free(d);
 	return NULL;
 }
 
+uint32_t dict_ht_size(uint32_t size, uint32_t symbols) {
+
+	return ht_next_size((uint64_t)size + size/2 + symbols + 1, symbols + 1, DICT_MAX_SIZE);
+}
+
+int dict_reserve(struct dictionary* d, uint32_t records) {
+
+	uint64_t	ht_size;
+
+	if (d == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!d->compression || d->ht_size == d->ht_max_size)
+		return 0;
+
+	if (records > d->size)
+		records = d->size;
+
+	// table size for which records fill it up to the maximum load factor
+	ht_size = (uint64_t)records * HT_MAX_LOAD_DEN / HT_MAX_LOAD_NUM + d->symbols + 2;
+	if (ht_size <= d->ht_size)
+		return 0;
+
+	return ht_rehash(d, ht_next_size(ht_size, d->symbols + 1, d->ht_max_size));
+}
+
+/**
+ * Puts in @p ht_size the largest hash table a compression dictionary of
+ * @p records records (intermediate nodes included) and maximum table size
+ * @p ht_max_size gets, and in @p prev the table it grows from, growing on
+ * demand (see dict_fill()) if @p reserve is not set, at once by
+ * dict_reserve() otherwise.
+ * @internal
+ */
+static void ht_growth(uint64_t records, uint32_t ht_max_size, uint32_t symbols, int reserve, uint32_t* ht_size, uint32_t* prev) {
+
+	uint32_t base = symbols + 1;
+
+	*prev = 0;
+	*ht_size = ht_next_size((uint64_t)base + HT_START_SIZE, base, ht_max_size);
+
+	if (reserve && records * HT_MAX_LOAD_DEN / HT_MAX_LOAD_NUM + base + 1 > *ht_size) {
+		*prev = *ht_size;
+		*ht_size = ht_next_size(records * HT_MAX_LOAD_DEN / HT_MAX_LOAD_NUM + base + 1, base, ht_max_size);
+	}
+
+	// the table grows when more records than its maximum load are filled
+	while (*ht_size < ht_max_size && records > (uint64_t)(*ht_size - base) * HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN) {
+		*prev = *ht_size;
+		*ht_size = ht_next_size(2 * (uint64_t)*ht_size - base, base, ht_max_size);
+	}
+}
+
+uint64_t dict_memory_estimate(uint32_t size, int compression, uint32_t ht_size, uint32_t symbols, uint8_t growth, int track_uses) {
+
+	uint64_t	record, table, scratch, inner = 0, recycle = 0;
+	uint32_t	grown, prev;
+	int			reserve;
+
+	if (size > DICT_MAX_SIZE || size > ht_size || size < symbols || growth > GROWTH_LZMW) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	if (!compression && growth != GROWTH_LZW) { // the decompressor builds a compression dictionary
+		compression = 1;
+		ht_size = dict_ht_size(size, symbols);
+	}
+
+	if (growth == GROWTH_LZMW) {
+		inner = size < DICT_MAX_SIZE - size ? size : DICT_MAX_SIZE - size;
+		if (dict_ht_size(size + inner, symbols) > ht_size)
+			ht_size = dict_ht_size(size + inner, symbols);
+	}
+
+	// dict_recycle() works on a copy of the records and on two arrays of subtree uses
+	if (track_uses)
+		recycle = (sizeof(uint32_t) + sizeof(uint8_t)) * (uint64_t)size + 2 * sizeof(uint64_t) * ((uint64_t)size + 1);
+
+	record = sizeof(uint64_t) + sizeof(uint32_t);
+	table = packed_bytes(size, packed_bits(size));
+	scratch = recycle;
+
+	// while the hash table grows the old one is still there: the compressor
+	// grows it on demand, or reserves it for the size of the input
+	if (compression) {
+		table = 0;
+		for (reserve = 0; reserve < 2; reserve++) {
+			ht_growth(size + inner, ht_size, symbols, reserve, &grown, &prev);
+			if (record * grown + (record * prev > recycle ? record * prev : recycle) > table + scratch) {
+				table = record * grown;
+				scratch = record * prev > recycle ? record * prev : recycle;
+			}
+		}
+	}
+
+	return sizeof(struct dictionary) + table + scratch + (compression ? sizeof(struct hot_t) * HOT_SIZE : 0)
+			+ (track_uses ? sizeof(uint16_t) * (uint64_t)size : 0)
+			+ (growth != GROWTH_LZW ? sizeof(uint32_t) * (size + inner) : 0)
+			+ size + inner + 1; // longest word of dict_word()
+}
+
+uint64_t dict_memory_usage(const struct dictionary* d) {
+
+	if (d == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	return sizeof(*d) + (d->compression ? (uint64_t)d->ht_size * (sizeof(*d->ht.key) + sizeof(*d->ht.next)) : packed_bytes(d->size, d->pack_bits))
+			+ (d->hot != NULL ? sizeof(*d->hot) * HOT_SIZE : 0)
+			+ (d->uses != NULL ? sizeof(*d->uses) * (uint64_t)d->size : 0)
+			+ (d->slot != NULL ? sizeof(*d->slot) * ((uint64_t)d->size + d->inner) : 0)
+			+ (d->word != NULL ? d->max_size + 1 : 0);
+}
+
 void dict_delete(struct dictionary* d) {
 
 	if (d != NULL) {
-		free(d->ht.current);
-		free(d->ht.symbol);
+		free(d->ht.key);
 		free(d->ht.next);
+		free(d->hot);
+		free(d->packed);
+		free(d->uses);
+		free(d->slot);
 		free(d->word);
 		free(d);
 	}
@@ -132,10 +693,14 @@ uint16_t dict_init(struct dictionary* d) {
 
 	// set initial symbols from root
 	for (i = 0; i <= d->symbols; i++) {
-		d->ht.current[i] = ROOT_NODE;
-		d->ht.symbol[i] = i;
-		if (d->compression) // decompressor doesn't need next field
+		if (d->compression) {
+			d->ht.key[i] = ht_key(ROOT_NODE, i);
 			d->ht.next[i] = i;
+		}
+		else // decompressor doesn't need next field
+			packed_set(d, i, ROOT_NODE, i);
+		if (d->slot != NULL)
+			d->slot[i] = i;
 	}
 
 	if (d->compression) // decompressor doesn't need to clean empty records
@@ -153,17 +718,22 @@ uint16_t dict_reinit(struct dictionary* d) {
 		return 0;
 	}
 	
-	for (i = d->symbols+1; i < d->ht_size; i++)
-		d->ht.current[i] = EMPTY_NODE;
+	STATS_RESET(d->ht_count, d->ht_size - d->symbols - 1);
+
+	for (i = d->symbols+1; i < d->ht_size && d->compression; i++)
+		d->ht.key[i] = HT_EMPTY_KEY;
+	hot_clear(d);
+	d->ht_count = 0;
+	d->inner_count = 0;
 	
 	return d->symbols+1;
 }
 
 int dict_lookup(const struct dictionary* d, uint32_t current, uint16_t symbol, uint32_t *ht_index) {
 
-	uint32_t i;
+	uint64_t k;
 
-	if (d == NULL || ((symbol > d->symbols-1 && symbol != EOF_SYMBOL)) || (current > d->size-1 && current != ROOT_NODE) ) {
+	if (d == NULL || (symbol > d->symbols-1 && (symbol != EOF_SYMBOL || current != ROOT_NODE)) || (current > d->size+d->inner-1 && current != ROOT_NODE) ) {
 		errno = EINVAL;
 		return -1;
 	}
@@ -173,63 +743,223 @@ int dict_lookup(const struct dictionary* d, uint32_t current, uint16_t symbol, u
 		return 1;
 	}
 
-	*ht_index = dict_hash(current, symbol, d->symbols+1, d->ht_size);
+	// children of base nodes may be in the base: its slots come after ours
+	if (d->base != NULL && current < d->base->size && dict_lookup(d->base, current, symbol, ht_index) == 1) {
+		*ht_index += d->ht_size;
+		return 1;
+	}
 
-	for (i = 0; ; i++) {
-		if (d->ht.current[*ht_index] == current && d->ht.symbol[*ht_index] == symbol) // symbol found
-			return 1;
-		else if (d->ht.current[*ht_index] == EMPTY_NODE) // empty record found
-			return 0;
+	k = ht_key(current, symbol);
+	*ht_index = d->probe(d->ht.key, dict_hash(current, symbol, d->symbols+1, d->ht_size), d->symbols+1, d->ht_size, k);
 
-		(*ht_index)++;
-		if (*ht_index == d->ht_size)
-			*ht_index = d->symbols + 1;
+	if (d->ht.key[*ht_index] == HT_EMPTY_KEY) { // empty record found
+		STATS_PROBE(0, probe_skipped(d, current, symbol, *ht_index));
+		return 0;
 	}
+
+	STATS_PROBE(1, probe_skipped(d, current, symbol, *ht_index));
+	return 1;
 }
 
 int dict_fill(struct dictionary* d, uint32_t ht_index, uint32_t current, uint8_t symbol, uint32_t next) {
 
-	if (d == NULL || ht_index > d->ht_size || symbol > d->symbols || (current > d->size-1 && current != ROOT_NODE)) {
+	if (d == NULL || ht_index >= d->ht_size || symbol > d->symbols || (current > d->size+d->inner-1 && current != ROOT_NODE)) {
 		errno = EINVAL;
 		return 0;
 	}
 
-	if (current != ROOT_NODE) // ROOT_NODE as current means don't change it
-		d->ht.current[ht_index] = current;
+	if (!d->compression) {
+		if (current == ROOT_NODE) // ROOT_NODE as current means don't change it
+			current = packed_parent(packed_get(d, ht_index));
+		packed_set(d, ht_index, current, symbol);
+		return 1;
+	}
 
-	d->ht.symbol[ht_index] = symbol;
-	if (d->compression)
-		d->ht.next[ht_index] = next;
+	if (current == ROOT_NODE) // ROOT_NODE as current means don't change it
+		current = key_current(d->ht.key[ht_index]);
+
+	// a record replaced must not stay in the hot record cache
+	if (d->hot != NULL && d->ht.key[ht_index] != HT_EMPTY_KEY)
+		d->hot[hot_index(d->ht.key[ht_index])].key = HT_EMPTY_KEY;
+
+	d->ht.key[ht_index] = ht_key(current, symbol);
+	d->ht.next[ht_index] = next;
+	if (d->slot != NULL)
+		d->slot[next] = ht_index;
+
+	// keep the load factor low while the dictionary grows
+	if (++d->ht_count > d->ht_grow_at) {
+		uint64_t ht_size = 2 * (uint64_t)d->ht_size - d->symbols - 1;
+		if (ht_rehash(d, ht_next_size(ht_size, d->symbols + 1, d->ht_max_size)) < 0)
+			return 0;
+	}
 
 	return 1;
 }
 
+/**
+ * Body of the dict_match() kernels: dict_lookup() and dict_next() for each
+ * symbol of @p in, without their checks, which dict_match_kernel() does once.
+ * Being always inlined, it is compiled once for each value of @p with_base
+ * and @p probe: the kernel without a base has no trace of it, and the probe
+ * is inlined with the instructions its kernel is compiled for.
+ * @internal
+ */
+static inline __attribute__((always_inline)) uint32_t match_symbols(const struct dictionary* d, uint32_t* cur, const uint8_t* in, uint32_t len, uint32_t* ht_index, const int with_base, const probe_fn probe) {
+
+	const uint64_t	*key = d->ht.key;
+	const uint32_t	*next = d->ht.next;
+	struct hot_t	*h;
+	uint32_t		node = *cur, first = d->symbols + 1, ht_size = d->ht_size, i, j;
+	uint32_t		depth = node < first ? 1 : HOT_DEPTH; // of node, unknown deeper than a root child
+	uint64_t		k;
+
+	for (i = 0; i < len; i++, depth++) {
+		if (node == ROOT_NODE) { // children of the root are the symbols themselves
+			node = in[i];
+			depth = 0;
+			continue;
+		}
+
+		// every phrase starts at the top of the tree: its records are the
+		// hottest ones, and are looked up in the cache first
+		k = ht_key(node, in[i]);
+		h = NULL;
+		if (depth < HOT_DEPTH) {
+			h = &d->hot[hot_index(k)];
+			STATS_HOT(h->key == k);
+			if (h->key == k) {
+				node = h->next;
+				continue;
+			}
+		}
+
+		if (with_base && node < d->base->size && dict_lookup(d->base, node, in[i], &j) == 1) {
+			node = d->base->ht.next[j];
+			if (h != NULL) {
+				h->key = k;
+				h->next = node;
+			}
+			continue;
+		}
+
+		j = probe(key, dict_hash(node, in[i], first, ht_size), first, ht_size, k);
+		if (key[j] == HT_EMPTY_KEY) {
+			STATS_PROBE(0, probe_skipped(d, node, in[i], j));
+			*cur = node;
+			*ht_index = j;
+			return i;
+		}
+		STATS_PROBE(1, probe_skipped(d, node, in[i], j));
+		node = next[j];
+		if (h != NULL) {
+			h->key = k;
+			h->next = node;
+		}
+	}
+
+	*cur = node;
+	return len;
+}
+
+/**
+ * Defines the dict_match() kernels of the dictionaries without and with a
+ * base, match_plain_<isa>() and match_base_<isa>(), which probe with
+ * probe_<isa>() and are compiled with function attributes @p attr.
+ * @internal
+ */
+#define MATCH_KERNELS(isa, attr) \
+	static attr uint32_t match_plain_##isa(const struct dictionary* d, uint32_t* cur, const uint8_t* in, uint32_t len, uint32_t* ht_index) { \
+		return match_symbols(d, cur, in, len, ht_index, 0, probe_##isa); \
+	} \
+	static attr uint32_t match_base_##isa(const struct dictionary* d, uint32_t* cur, const uint8_t* in, uint32_t len, uint32_t* ht_index) { \
+		return match_symbols(d, cur, in, len, ht_index, 1, probe_##isa); \
+	}
+
+MATCH_KERNELS(generic, )
+#ifdef CPU_X86
+MATCH_KERNELS(sse42, __attribute__((target("sse4.2"))))
+MATCH_KERNELS(avx2, __attribute__((target("avx2"))))
+MATCH_KERNELS(avx512, __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+/**
+ * dict_match() kernels by CPU level, without and with a base.
+ * @internal
+ */
+static const dict_match_fn match_kernels[CPU_LEVELS][2] = {
+	{ match_plain_generic, match_base_generic },
+#ifdef CPU_X86
+	{ match_plain_sse42, match_base_sse42 },
+	{ match_plain_avx2, match_base_avx2 },
+	{ match_plain_avx512, match_base_avx512 },
+#else
+	{ match_plain_generic, match_base_generic },
+	{ match_plain_generic, match_base_generic },
+	{ match_plain_generic, match_base_generic },
+#endif
+};
+
+dict_match_fn dict_match_kernel(const struct dictionary* d) {
+
+	if (d == NULL || !d->compression || d->growth != GROWTH_LZW || d->hot == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return match_kernels[cpu_level()][d->base != NULL];
+}
+
 uint32_t dict_next(const struct dictionary* d, uint32_t ht_index) {
 
-	if (d == NULL || ht_index > d->ht_size || d->compression == 0) {
+	if (d == NULL || d->compression == 0 || (ht_index >= d->ht_size && d->base == NULL)) {
 		errno = EINVAL;
 		return ROOT_NODE;
 	}
 
+	if (ht_index >= d->ht_size) // slot of the base, see dict_lookup()
+		return dict_next(d->base, ht_index - d->ht_size);
+
 	return d->ht.next[ht_index];
 }
 
 char* dict_word(struct dictionary* d, uint32_t node_index, uint32_t* len) {
 
 	uint32_t		cur, i = 0, l = 0;
+	uint8_t			symbol;
 	char			swap;
 
-	if (d == NULL || node_index > d->size-1 || len == NULL) {
+	if (d == NULL || node_index > d->size+d->inner-1 || len == NULL || (d->compression && d->slot == NULL)) {
 		errno = EINVAL;
 		return NULL;
 	}
 
 	while(node_index != ROOT_NODE) {
-		cur = node_index;
+		if (d->base != NULL && node_index >= d->base->rec_first && node_index < d->base->size) {
+			cur = node_index - d->base->rec_first;
+			symbol = d->base->rec_symbol[cur];
+			node_index = d->base->rec_current[cur];
+		}
+		else if (d->packed != NULL) {
+			uint64_t v = packed_get(d, node_index);
+
+			symbol = (uint8_t)v;
+			node_index = packed_parent(v);
+		}
+		else {
+			cur = d->slot[node_index]; // compression layout is indexed by slot
+			symbol = (uint8_t)d->ht.key[cur];
+			node_index = key_current(d->ht.key[cur]);
+		}
 
 		if (l == d->max_size) { // reallocate a bigger buffer
 			char *reallocated;
-			d->max_size *= 2;
+			// a word is never longer than the nodes of the tree: a longer walk is a loop
+			if (d->max_size >= d->size + d->inner) {
+				errno = EINVAL;
+				return NULL;
+			}
+			d->max_size = d->max_size < (d->size + d->inner) / 2 ? 2 * d->max_size : d->size + d->inner;
 			reallocated = realloc(d->word, d->max_size+1);
 			if (reallocated == NULL) {
 				free(d->word);
@@ -241,9 +971,8 @@ char* dict_word(struct dictionary* d, uint32_t node_index, uint32_t* len) {
 			d->word = reallocated;
 		}
 
-		d->word[l] = (char) d->ht.symbol[cur];
+		d->word[l] = (char) symbol;
 		l++;
-		node_index = d->ht.current[cur];
 	}
 
 	// reverse the string and add '\0'
@@ -269,9 +998,342 @@ uint16_t dict_first_symbol(const struct dictionary* d, uint32_t node_index) {
 	}
 
 	while (node_index != ROOT_NODE) {
+		if (d->base != NULL && node_index >= d->base->rec_first && node_index < d->base->size) {
+			// the parent of a base record is never the root
+			node_index = d->base->rec_current[node_index - d->base->rec_first];
+			continue;
+		}
 		cur = node_index;
-		node_index = d->ht.current[node_index];
+		node_index = d->packed != NULL ? packed_parent(packed_get(d, node_index)) : key_current(d->ht.key[node_index]);
+	}
+
+	return d->packed != NULL ? (uint8_t)packed_get(d, cur) : (uint8_t)d->ht.key[cur];
+}
+
+int dict_track_uses(struct dictionary* d) {
+
+	if (d == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (d->uses == NULL) {
+		d->uses = calloc(d->size, sizeof(*d->uses));
+		if (d->uses == NULL)
+			return -1;
+	}
+
+	return 0;
+}
+
+void dict_use(struct dictionary* d, uint32_t node_index) {
+
+	if (d->uses != NULL && node_index < d->size && d->uses[node_index] < UINT16_MAX)
+		d->uses[node_index]++;
+}
+
+int dict_set_growth(struct dictionary* d, uint8_t growth) {
+
+	uint32_t	inner = 0, ht_size;
+
+	if (d == NULL || !d->compression || growth > GROWTH_LZMW) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	d->growth = growth;
+	if (growth == GROWTH_LZW)
+		return 0;
+
+	// LZMW phrases are not prefix closed: their missing prefixes are
+	// intermediate nodes, with indexes from size on
+	if (growth == GROWTH_LZMW) {
+		inner = d->size < DICT_MAX_SIZE - d->size ? d->size : DICT_MAX_SIZE - d->size;
+		ht_size = dict_ht_size(d->size + inner, d->symbols);
+		if (d->ht_max_size < ht_size) {
+			d->ht_max_size = ht_size;
+			ht_set_grow_at(d);
+		}
 	}
 
-	return d->ht.symbol[cur];
+	d->slot = malloc(sizeof(*d->slot) * ((uint64_t)d->size + inner));
+	if (d->slot == NULL)
+		return -1;
+	d->inner = inner;
+
+	return 0;
+}
+
+uint32_t dict_grow(struct dictionary* d, uint32_t prev, const uint8_t* word, uint32_t len, uint32_t next_record) {
+
+	uint32_t	i, y, child, node = prev;
+
+	if (d == NULL || d->slot == NULL || word == NULL || len == 0 || prev > d->size-1) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	// no room for the intermediate nodes: call the dictionary full
+	if (d->growth == GROWTH_LZMW && (uint64_t)d->inner_count + len - 1 > d->inner)
+		return d->size;
+
+	// walk the concatenation from prev, adding the nodes it lacks
+	for (i = 0; i < len && next_record < d->size; i++) {
+		if (dict_lookup(d, node, word[i], &y)) {
+			node = dict_next(d, y);
+			continue;
+		}
+
+		if (d->growth == GROWTH_LZMW && i < len - 1)
+			child = d->size + d->inner_count++;
+		else
+			child = next_record++;
+
+		if (!dict_fill(d, y, node, word[i], child))
+			return 0;
+		node = child;
+	}
+
+	return next_record;
+}
+
+/**
+ * Puts in @p parent and @p symbol the parent and the symbol of each record
+ * of compression dictionary @p d from @p first_record to (@p next_record - 1).
+ * @internal
+ */
+static void collect_records(const struct dictionary* d, uint32_t first_record, uint32_t next_record, uint32_t* parent, uint8_t* symbol) {
+
+	uint32_t i;
+
+	for (i = 0; i < next_record - first_record; i++)
+		parent[i] = ROOT_NODE;
+	for (i = d->symbols + 1; i < d->ht_size; i++) {
+		if (d->ht.key[i] == HT_EMPTY_KEY || d->ht.next[i] < first_record || d->ht.next[i] >= next_record)
+			continue;
+		parent[d->ht.next[i] - first_record] = key_current(d->ht.key[i]);
+		symbol[d->ht.next[i] - first_record] = (uint8_t)d->ht.key[i];
+	}
+}
+
+/**
+ * Rearranges @p v so that its @p k-th element (starting from 0) is the one
+ * that would be there if @p v was sorted in decreasing order, and returns it.
+ * @internal
+ */
+static uint64_t nth_largest(uint64_t* v, uint32_t n, uint32_t k) {
+
+	uint32_t	lo = 0, hi = n, gt, eq, i;
+	uint64_t	pivot, swap;
+
+	// three-way partition of v[lo..hi) in (> pivot, == pivot, < pivot)
+	while (hi - lo > 1) {
+		pivot = v[lo + (hi - lo) / 2];
+		gt = eq = lo;
+		for (i = lo; i < hi; i++) {
+			if (v[i] < pivot)
+				continue;
+			swap = v[i];
+			v[i] = v[eq];
+			if (swap > pivot) {
+				v[eq] = v[gt];
+				v[gt++] = swap;
+			}
+			else
+				v[eq] = swap;
+			eq++;
+		}
+		if (k < gt)
+			hi = gt;
+		else if (k < eq)
+			return pivot;
+		else
+			lo = eq;
+	}
+
+	return v[k];
+}
+
+uint32_t dict_recycle(struct dictionary* d, uint32_t first_record, uint32_t next_record, uint32_t keep) {
+
+	uint32_t	i, n, kept, ties, *parent = NULL;
+	uint8_t		*symbol = NULL;
+	uint64_t	*sub = NULL, *tmp = NULL, threshold;
+
+	if (d == NULL || d->uses == NULL || first_record <= d->symbols || next_record > d->size || next_record < first_record) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	n = next_record - first_record;
+	if (keep > n)
+		keep = n;
+
+	// work on a copy of the records, indexed by node
+	parent = malloc(sizeof(*parent) * n);
+	symbol = malloc(sizeof(*symbol) * n);
+	if (parent == NULL || symbol == NULL)
+		goto error;
+	dict_records(d, first_record, next_record, parent, symbol);
+
+	// uses of each subtree: a parent always comes before its children
+	sub = malloc(sizeof(*sub) * (n + 1));
+	tmp = malloc(sizeof(*tmp) * (n + 1));
+	if (sub == NULL || tmp == NULL)
+		goto error;
+	for (i = 0; i < n; i++)
+		sub[i] = d->uses[first_record + i];
+	for (i = n; i-- > 0; )
+		if (parent[i] >= first_record && parent[i] < next_record)
+			sub[parent[i] - first_record] += sub[i];
+
+	// keep the most used subtrees: a child never ranks before its parent,
+	// because its uses are not more and its index is higher
+	threshold = 1;
+	if (keep > 0) {
+		memcpy(tmp, sub, sizeof(*sub) * n);
+		threshold = nth_largest(tmp, n, keep - 1);
+		if (threshold == 0)
+			threshold = 1;
+	}
+	for (i = 0, ties = keep; i < n; i++)
+		if (sub[i] > threshold)
+			ties--;
+
+	// renumber the kept records in their order; the new index of record i is
+	// never higher than i, so it can be done in place
+	for (i = 0, kept = 0; i < n && keep > 0; i++) {
+		uint32_t p = parent[i];
+
+		if (sub[i] < threshold || (sub[i] == threshold && ties == 0)) {
+			sub[i] = ROOT_NODE; // not kept
+			continue;
+		}
+		if (sub[i] == threshold)
+			ties--;
+
+		if (p >= first_record && p < next_record)
+			p = sub[p - first_record];
+		sub[i] = first_record + kept; // new index, used by children
+		parent[kept] = p;
+		symbol[kept] = symbol[i];
+		d->uses[first_record + kept] = d->uses[first_record + i] >> 1;
+		kept++;
+	}
+	for (i = first_record + kept; i < next_record; i++)
+		d->uses[i] = 0;
+
+	// the compressor rebuilds its hash table with the kept records, the
+	// decompressor packs them back
+	if (d->compression) {
+		uint32_t y;
+
+		dict_reinit(d);
+		for (i = 0; i < kept; i++) {
+			dict_lookup(d, parent[i], symbol[i], &y);
+			if (!dict_fill(d, y, parent[i], symbol[i], first_record + i))
+				goto error;
+		}
+	}
+	else {
+		for (i = 0; i < kept; i++)
+			packed_set(d, first_record + i, parent[i], symbol[i]);
+	}
+	free(parent);
+	free(symbol);
+
+	LOG("Dictionary recycled: kept %u records out of %u", kept, n);
+
+	free(sub);
+	free(tmp);
+	return first_record + kept;
+
+error:
+	free(parent);
+	free(symbol);
+	free(sub);
+	free(tmp);
+	errno = ENOMEM;
+	return 0;
+}
+
+int dict_records(const struct dictionary* d, uint32_t first_record, uint32_t next_record, uint32_t* parent, uint8_t* symbol) {
+
+	if (d == NULL || parent == NULL || symbol == NULL || first_record <= d->symbols || next_record > d->size || next_record < first_record) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (d->compression)
+		collect_records(d, first_record, next_record, parent, symbol);
+	else {
+		uint32_t i;
+
+		for (i = first_record; i < next_record; i++) {
+			uint64_t v = packed_get(d, i);
+
+			parent[i - first_record] = packed_parent(v);
+			symbol[i - first_record] = (uint8_t)v;
+		}
+	}
+
+	return 0;
+}
+
+struct dictionary* dict_new_base(uint32_t symbols, uint32_t first_record, uint32_t records, const uint32_t* parent, const uint8_t* symbol) {
+
+	struct dictionary	*d;
+	uint32_t			i, y, size = first_record + records;
+
+	if (parent == NULL || symbol == NULL || first_record <= symbols || size < first_record || size > DICT_MAX_SIZE) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	d = dict_new(size, 1, dict_ht_size(size, symbols), symbols);
+	if (d == NULL)
+		return NULL;
+	dict_init(d);
+	if (dict_reserve(d, records) < 0)
+		goto error;
+
+	// a record must follow its parent, and be the only one with its parent and symbol
+	for (i = 0; i < records; i++) {
+		if ((parent[i] >= symbols && parent[i] < first_record) || parent[i] >= first_record + i || symbol[i] >= symbols)
+			goto invalid;
+		if (dict_lookup(d, parent[i], symbol[i], &y) != 0)
+			goto invalid;
+		if (!dict_fill(d, y, parent[i], symbol[i], first_record + i))
+			goto error;
+	}
+
+	d->rec_first = first_record;
+	d->rec_current = parent;
+	d->rec_symbol = symbol;
+
+	// a base is only read, through the dictionaries using it: they cache its records
+	free(d->hot);
+	d->hot = NULL;
+
+	return d;
+
+invalid:
+	LOG("Invalid base record %u", first_record + i);
+	errno = EINVAL;
+error:
+	dict_delete(d);
+	return NULL;
+}
+
+uint32_t dict_set_base(struct dictionary* d, const struct dictionary* base, uint32_t first_record) {
+
+	if (d == NULL || base == NULL || base->rec_current == NULL || base->symbols != d->symbols || base->rec_first != first_record
+			|| base->size >= d->size || (uint64_t)d->ht_max_size + base->ht_size > UINT32_MAX) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	d->base = base;
+
+	return base->size;
 }
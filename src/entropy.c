@@ -0,0 +1,385 @@
+/**
+ * @file	entropy.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for entropy module, an adaptive range coder for dictionary codes.
+ * @internal
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bitio.h"
+#include "debug.h"
+#include "entropy.h"
+
+#define PROB_BITS		11						/**< Precision of the bit probabilities. */
+#define PROB_INIT		(1 << (PROB_BITS - 1))	/**< Initial probability: both bit values equally likely. */
+#define MOVE_BITS		5						/**< Adaptation speed of the probabilities (higher is slower). */
+#define TOP				((uint32_t)1 << 24)		/**< The range is normalized to stay above this value. */
+
+#define BUCKET_BITS		6						/**< Bits of a bucket symbol. */
+#define BUCKETS			(1 << BUCKET_BITS)		/**< Number of bucket symbols. */
+#define LITERAL_BUCKET	32						/**< Bucket symbol of codes below the first record. */
+#define LITERAL_BITS	9						/**< Bits of a code below the first record. */
+#define ALIGN_BITS		3						/**< Bits below the most significant one coded with a model. */
+#define DIRECT_BITS		16						/**< Maximum number of direct bits coded at once. */
+
+/**
+ * Structure of the entropy coder context.
+ * @internal
+ */
+struct entropy {
+	struct bitio	*f;							/**< Stream where coded bytes are written or read. */
+	int				encode;						/**< Indicates if the context writes or reads. */
+	uint32_t		first_record;				/**< Index of the first record of the dictionary. */
+	uint32_t		range;						/**< Width of the current interval. */
+	uint64_t		low;						/**< Lower bound of the interval (encoder). */
+	uint32_t		code;						/**< Value read from the stream, minus lower bound (decoder). */
+	uint8_t			cache;						/**< Byte not written yet because of a possible carry (encoder). */
+	uint64_t		cache_size;					/**< Number of pending bytes, the cache and 0xFF bytes (encoder). */
+	uint32_t		context;					/**< Previous bucket symbol. */
+	uint16_t		bucket[BUCKETS][BUCKETS];	/**< Probabilities of the bucket tree, per context. */
+	uint16_t		literal[1 << LITERAL_BITS];	/**< Probabilities of the tree of codes below the first record. */
+	uint16_t		align[BUCKETS][1 << ALIGN_BITS];	/**< Probabilities of the trees of the top bits of distances, per bucket. */
+	uint64_t		bytes;						/**< Bytes buffered for the bitio context, first in the low bits. */
+	int				nbytes;						/**< Number of bytes in the buffer (encoder) or still to be used (decoder). */
+	int				error;						/**< Set when the stream cannot be written or read. */
+};
+
+/**
+ * Writes @p byte to the stream, 8 bytes at a time.
+ * @internal
+ */
+static inline void put_byte(struct entropy* e, uint8_t byte) {
+
+	e->bytes |= (uint64_t)byte << (8 * e->nbytes);
+	if (++e->nbytes == 8) {
+		if (bitio_write(e->f, e->bytes, 64) != 64)
+			e->error = 1;
+		e->bytes = 0;
+		e->nbytes = 0;
+	}
+}
+
+/**
+ * Writes the top byte of the lower bound, propagating a pending carry.
+ * @internal
+ */
+static void shift_low(struct entropy* e) {
+
+	if ((uint32_t)e->low < 0xFF000000 || (e->low >> 32) != 0) {
+		uint8_t carry = e->low >> 32, byte = e->cache;
+
+		do {
+			put_byte(e, byte + carry);
+			byte = 0xFF;
+		} while (--e->cache_size != 0);
+		e->cache = (e->low >> 24) & 0xFF;
+	}
+	e->cache_size++;
+	e->low = (e->low & 0x00FFFFFF) << 8;
+}
+
+/**
+ * Returns the next byte of the coded stream.
+ * @internal
+ */
+static inline uint32_t next_byte(struct entropy* e) {
+
+	uint32_t byte;
+
+	// the stream ends with the coder's bytes: reading ahead is harmless
+	if (e->nbytes == 0) {
+		int n = bitio_read(e->f, &e->bytes, 64);
+		if (n < 8) {
+			e->error = 1;
+			return 0;
+		}
+		e->nbytes = n / 8;
+	}
+
+	byte = e->bytes & 0xFF;
+	e->bytes >>= 8;
+	e->nbytes--;
+	return byte;
+}
+
+/**
+ * Codes @p bit with probability of zero @p *p, and adapts it.
+ * @internal
+ */
+static inline void put_bit(struct entropy* e, uint16_t* p, uint32_t bit) {
+
+	uint32_t bound = (e->range >> PROB_BITS) * *p;
+
+	if (bit == 0) {
+		e->range = bound;
+		*p += ((1 << PROB_BITS) - *p) >> MOVE_BITS;
+	}
+	else {
+		e->low += bound;
+		e->range -= bound;
+		*p -= *p >> MOVE_BITS;
+	}
+	while (e->range < TOP) {
+		e->range <<= 8;
+		shift_low(e);
+	}
+}
+
+/**
+ * Decodes a bit with probability of zero @p *p, and adapts it.
+ * @internal
+ */
+static inline uint32_t get_bit(struct entropy* e, uint16_t* p) {
+
+	uint32_t	bound = (e->range >> PROB_BITS) * *p, bit = e->code >= bound;
+	uint16_t	p0 = *p + (((1 << PROB_BITS) - *p) >> MOVE_BITS), p1 = *p - (*p >> MOVE_BITS);
+
+	// selections rather than branches: bits are often unpredictable
+	e->code -= bit ? bound : 0;
+	e->range = bit ? e->range - bound : bound;
+	*p = bit ? p1 : p0;
+
+	// a bit shrinks the range by less than 8 bits
+	if (e->range < TOP) {
+		e->range <<= 8;
+		e->code = (e->code << 8) | next_byte(e);
+	}
+	return bit;
+}
+
+/**
+ * Codes the @p bits low bits of @p value, all values being equally likely.
+ * Up to DIRECT_BITS bits are coded at once, by splitting the range evenly.
+ * @internal
+ */
+static inline void put_direct(struct entropy* e, uint32_t value, int bits) {
+
+	int n;
+
+	while (bits > 0) {
+		n = bits < DIRECT_BITS ? bits : DIRECT_BITS;
+		bits -= n;
+		e->range >>= n;
+		e->low += (uint64_t)e->range * ((value >> bits) & ((1 << n) - 1));
+		while (e->range < TOP) {
+			e->range <<= 8;
+			shift_low(e);
+		}
+	}
+}
+
+/**
+ * Decodes @p bits bits written by put_direct().
+ * @internal
+ */
+static inline uint32_t get_direct(struct entropy* e, int bits) {
+
+	uint32_t	value = 0, v;
+	int			n;
+
+	while (bits > 0) {
+		n = bits < DIRECT_BITS ? bits : DIRECT_BITS;
+		bits -= n;
+		e->range >>= n;
+		v = e->code / e->range;
+		if (v >> n) { // only a corrupted stream gets here
+			e->error = 1;
+			v = 0;
+		}
+		e->code -= v * e->range;
+		value = (value << n) | v;
+		while (e->range < TOP) {
+			e->range <<= 8;
+			e->code = (e->code << 8) | next_byte(e);
+		}
+	}
+	return value;
+}
+
+/**
+ * Codes the @p bits bits of @p value with the binary tree of probabilities @p tree.
+ * @internal
+ */
+static inline void put_tree(struct entropy* e, uint16_t* tree, uint32_t value, int bits) {
+
+	uint32_t bit, node = 1;
+
+	while (bits-- > 0) {
+		bit = (value >> bits) & 1;
+		put_bit(e, &tree[node], bit);
+		node = (node << 1) | bit;
+	}
+}
+
+/**
+ * Decodes @p bits bits with the binary tree of probabilities @p tree.
+ * @internal
+ */
+static inline uint32_t get_tree(struct entropy* e, uint16_t* tree, int bits) {
+
+	uint32_t	node = 1;
+	int			i;
+
+	for (i = 0; i < bits; i++)
+		node = (node << 1) | get_bit(e, &tree[node]);
+
+	return node - ((uint32_t)1 << bits);
+}
+
+struct entropy* entropy_new(struct bitio* f, int encode, uint32_t first_record) {
+
+	struct entropy	*e;
+	uint32_t		i, j;
+
+	if (f == NULL || first_record > (1 << LITERAL_BITS)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	e = malloc(sizeof(*e));
+	if (e == NULL)
+		return NULL;
+
+	e->f = f;
+	e->encode = encode;
+	e->first_record = first_record;
+	e->range = 0xFFFFFFFF;
+	e->low = 0;
+	e->code = 0;
+	e->cache = 0;
+	e->cache_size = 1;
+	e->context = 0;
+	e->bytes = 0;
+	e->nbytes = 0;
+	e->error = 0;
+	for (i = 0; i < BUCKETS; i++)
+		for (j = 0; j < BUCKETS; j++)
+			e->bucket[i][j] = PROB_INIT;
+	for (i = 0; i < (1 << LITERAL_BITS); i++)
+		e->literal[i] = PROB_INIT;
+	for (i = 0; i < BUCKETS; i++)
+		for (j = 0; j < (1 << ALIGN_BITS); j++)
+			e->align[i][j] = PROB_INIT;
+
+	// the first byte written by the encoder is always 0
+	if (!encode) {
+		for (i = 0; i < 5; i++)
+			e->code = (e->code << 8) | next_byte(e);
+		if (e->error) {
+			free(e);
+			errno = EIO;
+			return NULL;
+		}
+	}
+
+	return e;
+}
+
+int entropy_put(struct entropy* e, uint32_t code, uint32_t n) {
+
+	uint32_t distance, bucket;
+
+	if (e == NULL || !e->encode || code >= n) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (code < e->first_record) {
+		put_tree(e, e->bucket[e->context], LITERAL_BUCKET, BUCKET_BITS);
+		put_tree(e, e->literal, code, LITERAL_BITS);
+		e->context = LITERAL_BUCKET;
+	}
+	else {
+		// distance from the newest record, plus one: the bucket is its bit length minus one
+		distance = n - code;
+		bucket = 31 - __builtin_clz(distance);
+		put_tree(e, e->bucket[e->context], bucket, BUCKET_BITS);
+		if (bucket <= ALIGN_BITS)
+			put_tree(e, e->align[bucket], distance, bucket);
+		else {
+			put_tree(e, e->align[bucket], distance >> (bucket - ALIGN_BITS), ALIGN_BITS);
+			put_direct(e, distance, bucket - ALIGN_BITS);
+		}
+		e->context = bucket;
+	}
+
+	if (e->error) {
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
+
+int entropy_get(struct entropy* e, uint32_t n, uint32_t* code) {
+
+	uint32_t distance, bucket;
+
+	if (e == NULL || e->encode || code == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	bucket = get_tree(e, e->bucket[e->context], BUCKET_BITS);
+	e->context = bucket;
+
+	if (bucket == LITERAL_BUCKET) {
+		*code = get_tree(e, e->literal, LITERAL_BITS);
+		if (*code >= e->first_record || *code >= n)
+			goto error;
+	}
+	else if (bucket < LITERAL_BUCKET) {
+		if (bucket <= ALIGN_BITS)
+			distance = ((uint32_t)1 << bucket) | get_tree(e, e->align[bucket], bucket);
+		else {
+			distance = get_tree(e, e->align[bucket], ALIGN_BITS) << (bucket - ALIGN_BITS);
+			distance |= ((uint32_t)1 << bucket) | get_direct(e, bucket - ALIGN_BITS);
+		}
+		if (distance > n - e->first_record)
+			goto error;
+		*code = n - distance;
+	}
+	else
+		goto error;
+
+	if (e->error) {
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+
+error:
+	LOG("Invalid entropy coded symbol");
+	errno = EINVAL;
+	return -1;
+}
+
+int entropy_flush(struct entropy* e) {
+
+	int i;
+
+	if (e == NULL || !e->encode) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (i = 0; i < 5; i++)
+		shift_low(e);
+	if (e->nbytes > 0 && bitio_write(e->f, e->bytes, 8 * e->nbytes) != 8 * e->nbytes)
+		e->error = 1;
+	e->nbytes = 0;
+
+	if (e->error) {
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
+
+void entropy_delete(struct entropy* e) {
+
+	free(e);
+}
@@ -6,42 +6,90 @@
  */
 
 #include <ctype.h>
+#include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "autosize.h"
 #include "common.h"
 #include "compressor.h"
 #include "decompressor.h"
+#include "dictfile.h"
 #include "dictionary.h"
+#include "entropy.h"
 #include "main_utils.h"
+#include "memlimit.h"
+#include "phases.h"
+#include "stats.h"
+#include "telemetry.h"
 #include "verbose.h"
 
 #define DEFAULT_DICT_SIZE	1048576
 #define DEFAULT_HT_SIZE		1499933 + NUM_SYMBOLS + 1
 
 const char *help = "\
-Usage: lz78 [-c [-s <dict_size] [-t <table_size>] | -d] [-i <input_file>] [-o <output_file>] [-v]\n\n\
+Usage: lz78 [-c [-s <dict_size> | -s auto[:<objective>]] [-t <table_size>] [-r <policy>] [-g <growth>] [-e | --fast] [--sparse] [--store] [--estimate-memory] | -d] [-D <dictfile>] [-i <input_file>] [-o <output_file>] [-v] [--max-memory <size>] [--phases[=json]] [--telemetry <dest> [--telemetry-interval <ms>]]\n\
+       lz78 --train [-s <records>] [-i <sample_file> | <sample_file>...] -o <dictfile> [-v]\n\n\
 \
   -c               compress, cannot be specified together with -d\n\
   -d               decompress, cannot be specified together with -c\n\
+  -D <dictfile>    prime the dictionary with a dictionary file made by --train; the same file is needed to decompress\n\
+  -e               entropy code the dictionary codes, for a smaller output (only for compression)\n\
+  -g <growth>      how the dictionary grows (only for compression): lzw (default, last phrase and next symbol), lzap (previous phrase and each prefix of the last one) or lzmw (previous and last phrase); lzap and lzmw decompress much slower than lzw\n\
   -h               print this help\n\
   -i <input>       input from file instead of stdin\n\
   -m               perform md5 check (only for compression)\n\
   -o [<output>]    output to file instead of stdout, without agruments default filename is <input>.lz78 (compression) or orginal filename (decompression)\n\
+  -r <policy>      what to do when the dictionary is full (only for compression): reset (default), freeze, adaptive[:<percent>], manual or recycle\n\
   -s <dict_size>   set dictionary size (only for compression), <dict_size> must be between %d and %d\n\
-  -t <table_size>  set hash table size (only for compression), <table_size> must be greater than <dict_size>\n\
-  -v               be verbose to stdout if -o is specified, otherwise to stderr\n\n";
+  -s auto[:<obj>]  choose dictionary size by sampling the input file (only for compression, with the default -g and -r and without -e or --fast), <obj> is ratio (default), speed or memory\n\
+  -t <table_size>  set maximum hash table size (only for compression), <table_size> must be greater than <dict_size>\n\
+  -v               be verbose to stdout if -o is specified, otherwise to stderr\n\
+  --telemetry <dest>        write a JSON progress record every second to file descriptor <dest> (a number) or file <dest>\n\
+  --telemetry-interval <ms> time between two progress records, in milliseconds\n\
+  --fast           write the dictionary codes as whole 16 or 24-bit words, for a faster decompression and a larger output (only for compression, dictionaries up to %d records)\n\
+  --estimate-memory print the most memory the dictionaries of this compression and of its decompression can take, and exit\n\
+  --max-memory <size> memory the run may take (e.g. 256M, default the cgroup limit): compression picks the largest dictionary that compressor and decompressor can use within it, decompression refuses streams that need more\n\
+  --phases[=json]  report time, CPU and resource usage of each phase of the run (metadata, digest, dictionary, loop, resets, flush, close), as a table or as JSON\n\
+  --sparse         code each run of a byte as the byte and its length (only for compression, with lzw growth), on by default for input files with holes: runs of zeros are restored as holes\n\
+  --store          store the blocks of the input that would grow if coded as they are (only for compression, with lzw growth and without -e)\n\
+  --train          build a dictionary file of <records> records (default %d) from the sample files, or stdin\n\n";
+
+static const struct option long_options[] = {
+	{ "estimate-memory",	no_argument,		NULL,	'E' },
+	{ "fast",				no_argument,		NULL,	'F' },
+	{ "max-memory",			required_argument,	NULL,	'X' },
+	{ "phases",				optional_argument,	NULL,	'P' },
+	{ "sparse",				no_argument,		NULL,	'S' },
+	{ "store",				no_argument,		NULL,	'R' },
+	{ "telemetry",			required_argument,	NULL,	'M' },
+	{ "telemetry-interval",	required_argument,	NULL,	'I' },
+	{ "train",				no_argument,		NULL,	'T' },
+	{ NULL,		0,				NULL,	0 }
+};
+
+/**
+ * Handler of @c SIGUSR1: asks the compressor to reset the dictionary.
+ */
+static void reset_handler(int sig) {
+
+	compress_reset_request();
+}
 
 int main (int argc, char *argv[]) {
-	int				c, free_name = 0;
-	uint8_t			flags = 0, dec_flags = 0, meta_flags = 0;
-	uint32_t		dict_size, ht_size;
+	int				c, flags = 0, free_name = 0, objective = AUTO_RATIO, phases_json = 0;
+	uint8_t			dec_flags = 0, meta_flags = 0;
+	uint32_t		dict_size, ht_size, telemetry_interval = TELEMETRY_INTERVAL;
 	int64_t			filesize;
-	char			*in_file = NULL, *out_file = NULL;
+	uint64_t		max_memory = 0, budget;
+	char			*in_file = NULL, *out_file = NULL, *dict_file = NULL, *telemetry = NULL;
 	struct timeval	t1;
+	struct dictfile	*df = NULL;
+	struct comp_options	opts = { RESET_POLICY_RESET, 0, GROWTH_LZW, ENTROPY_NONE, 0, 0, NULL, 0 };
 
  	meta_flags = META_DICT_SIZE | META_NAME | META_TIMESTAMP;
 	dict_size = DEFAULT_DICT_SIZE;
@@ -49,7 +97,7 @@ int main (int argc, char *argv[]) {
 	VERBOSE_STREAM = stderr;
 
 	opterr = 0; // don't print error message
-	while ((c = getopt(argc, argv, "cdhvi:mo:s:t:")) != -1) {
+	while ((c = getopt_long(argc, argv, "cdD:eg:hvi:mo:r:s:t:", long_options, NULL)) != -1) {
 		switch (c) {
 			case 'c':
 				flags |= COMPRESS_FLAG;
@@ -59,8 +107,28 @@ int main (int argc, char *argv[]) {
 				flags |= DECOMPRESS_FLAG;
 				break;
 
+			case 'D':
+				dict_file = optarg;
+				flags |= DICT_FILE_FLAG;
+				break;
+
+			case 'e':
+				opts.entropy = ENTROPY_RANGE;
+				flags |= ENTROPY_FLAG;
+				break;
+
+			case 'g':
+				opts.growth = growth_parse(optarg);
+				if (opts.growth == GROWTH_ERROR) {
+					fprintf(stderr, "%s: Invalid dictionary growth\n", argv[0]);
+					fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				flags |= GROWTH_FLAG;
+				break;
+
 			case 'h':
-				printf(help, DICT_MIN_SIZE, DICT_MAX_SIZE);
+				printf(help, DICT_MIN_SIZE, DICT_MAX_SIZE, ENTROPY_BYTES_MAX_SIZE, DICTFILE_RECORDS);
 				exit(EXIT_SUCCESS);
 
 			case 'i':
@@ -76,8 +144,28 @@ int main (int argc, char *argv[]) {
 				VERBOSE_STREAM = stdout;
 				break;
 
+			case 'r':
+				opts.reset_policy = reset_policy_parse(optarg, &opts.reset_threshold);
+				if (opts.reset_policy == RESET_POLICY_ERROR) {
+					fprintf(stderr, "%s: Invalid dictionary reset policy\n", argv[0]);
+					fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				flags |= RESET_POLICY_FLAG;
+				break;
+
 			case 's':
-				dict_size = atoll(optarg);
+				if (strncmp(optarg, "auto", 4) == 0) {
+					objective = autosize_objective(optarg);
+					if (objective == AUTO_ERROR) {
+						fprintf(stderr, "%s: Invalid objective for automatic dictionary size\n", argv[0]);
+						fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+						exit(EXIT_FAILURE);
+					}
+					flags |= AUTO_SIZE_FLAG;
+				}
+				else
+					dict_size = atoll(optarg);
 				flags |= DICT_SIZE_FLAG;
 				break;
 
@@ -85,17 +173,75 @@ int main (int argc, char *argv[]) {
 				ht_size = atoll(optarg);
 				flags |= TABLE_SIZE_FLAG;
 				break;
+
+			case 'E':
+				flags |= ESTIMATE_FLAG;
+				break;
+
+			case 'F':
+				opts.entropy = ENTROPY_BYTES;
+				flags |= FAST_FLAG;
+				break;
+
+			case 'X':
+				if (memlimit_parse(optarg, &max_memory) < 0) {
+					fprintf(stderr, "%s: Invalid memory size\n", argv[0]);
+					fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				flags |= MAX_MEMORY_FLAG;
+				break;
+
+			case 'P':
+				if (optarg != NULL && strcmp(optarg, "json") != 0) {
+					fprintf(stderr, "%s: Invalid format of the phases, only json is supported\n", argv[0]);
+					fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				phases_json = optarg != NULL;
+				flags |= PHASES_FLAG;
+				break;
+
+			case 'S':
+				opts.runs = 1;
+				flags |= SPARSE_FLAG;
+				break;
+
+			case 'R':
+				opts.store = 1;
+				flags |= STORE_FLAG;
+				break;
+
+			case 'M':
+				telemetry = optarg;
+				break;
+
+			case 'I':
+				telemetry_interval = atoll(optarg);
+				if (telemetry_interval == 0) {
+					fprintf(stderr, "%s: Invalid telemetry interval\n", argv[0]);
+					fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+					exit(EXIT_FAILURE);
+				}
+				break;
+
+			case 'T':
+				flags |= TRAIN_FLAG;
+				break;
 				
 			case 'v':
 				VERBOSE_LEVEL++;
 				break;
 				
 			case '?': // unknown option or option without required argument
-				if (optopt == 'o')
+				if (optopt == 'o') { // -o without a file name: the original one
 					flags |= ORIG_FILENAME_FLAG;
 					break;
+				}
 				
-				if (optopt == 'i' || optopt == 's' || optopt == 't')
+				if (optopt == 'M' || optopt == 'I' || optopt == 'X')
+					fprintf(stderr, "%s: You cannot specify --%s option without an argument\n", argv[0], optopt == 'M' ? "telemetry" : optopt == 'I' ? "telemetry-interval" : "max-memory");
+				else if (optopt == 'D' || optopt == 'g' || optopt == 'i' || optopt == 'r' || optopt == 's' || optopt == 't')
 					fprintf(stderr, "%s: You cannot specify -%c option without an argument\n", argv[0], optopt);
 				else if (isprint (optopt))
 					fprintf(stderr, "%s: Unknown option '%c'\n", argv[0], optopt);
@@ -107,9 +253,134 @@ int main (int argc, char *argv[]) {
 		}
 	}
 
+	// a given dictionary size gets a table to match, not the one of the default size
+	if ((flags & DICT_SIZE_FLAG) && !(flags & (TABLE_SIZE_FLAG | AUTO_SIZE_FLAG)))
+		ht_size = dict_ht_size(dict_size, NUM_SYMBOLS);
+
 	if (check_args(argv[0], flags, in_file, out_file, dict_size, ht_size) < 0) // check if options are valid
 		exit(EXIT_FAILURE);
 
+	if (flags & TRAIN_FLAG) { // samples are -i or the arguments
+		int64_t records = in_file != NULL ? dictfile_train(out_file, &in_file, 1, (flags & DICT_SIZE_FLAG) ? dict_size : DICTFILE_RECORDS)
+				: dictfile_train(out_file, argv + optind, argc - optind, (flags & DICT_SIZE_FLAG) ? dict_size : DICTFILE_RECORDS);
+
+		if (records < 0) {
+			perror("Training Failed");
+			exit(EXIT_FAILURE);
+		}
+		exit(EXIT_SUCCESS);
+	}
+
+	if (dict_file != NULL) {
+		df = dictfile_open(dict_file);
+		if (df == NULL) {
+			perror(dict_file);
+			exit(EXIT_FAILURE);
+		}
+		opts.dictfile = df;
+	}
+
+	if (opts.growth != GROWTH_LZW && opts.reset_policy == RESET_POLICY_RECYCLE) {
+		fprintf(stderr, "%s: Reset policy recycle works only with lzw growth\n", argv[0]);
+		fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	if (opts.growth != GROWTH_LZW && opts.runs) {
+		fprintf(stderr, "%s: Option --sparse works only with lzw growth\n", argv[0]);
+		fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((opts.growth != GROWTH_LZW || opts.entropy == ENTROPY_RANGE) && opts.store) {
+		fprintf(stderr, "%s: Option --store works only with lzw growth and without -e\n", argv[0]);
+		fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	if ((flags & AUTO_SIZE_FLAG) && (opts.growth != GROWTH_LZW || opts.reset_policy != RESET_POLICY_RESET || opts.entropy != ENTROPY_NONE)) {
+		fprintf(stderr, "%s: Option -s auto works only with lzw growth, reset policy reset and without -e or --fast\n", argv[0]);
+		fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	if (flags & AUTO_SIZE_FLAG) { // sample the input to choose dictionary size
+		uint32_t size = autosize_select(in_file, objective, (flags & TABLE_SIZE_FLAG) ? ht_size : 0);
+
+		if (size != 0) {
+			dict_size = size;
+			if (!(flags & TABLE_SIZE_FLAG))
+				ht_size = dict_ht_size(size, NUM_SYMBOLS);
+		}
+		else
+			PRINT(1, "Automatic dictionary size not available, using %u\n", dict_size);
+	}
+
+	if (df != NULL && (flags & COMPRESS_FLAG) && dict_size <= dictfile_first_record(df) + dictfile_records(df)) {
+		if (!(flags & AUTO_SIZE_FLAG)) {
+			fprintf(stderr, "%s: Dictionary size must be greater than %u with this dictionary file\n", argv[0], dictfile_first_record(df) + dictfile_records(df));
+			fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+			dictfile_close(df);
+			exit(EXIT_FAILURE);
+		}
+		while (dict_size <= dictfile_first_record(df) + dictfile_records(df)) // room for new records too
+			dict_size *= 2;
+		if (!(flags & TABLE_SIZE_FLAG))
+			ht_size = dict_ht_size(dict_size, NUM_SYMBOLS);
+	}
+
+	// memory budget of the run: --max-memory, or the limit of the cgroup
+	budget = (flags & MAX_MEMORY_FLAG) ? max_memory : memlimit_cgroup();
+	if (budget != 0 && (flags & COMPRESS_FLAG)) {
+		uint64_t	shared = df != NULL ? dictfile_memory(df) : 0, needed, decomp;
+		int			track = opts.reset_policy == RESET_POLICY_RECYCLE;
+		uint32_t	size, size_ht;
+
+		needed = memlimit_needed(dict_size, ht_size, 1, opts.growth, track, shared);
+		decomp = memlimit_needed(dict_size, 0, 0, opts.growth, track, shared);
+		if (decomp > needed)
+			needed = decomp;
+
+		if ((flags & (DICT_SIZE_FLAG | TABLE_SIZE_FLAG)) && !(flags & AUTO_SIZE_FLAG)) { // given sizes are checked, not chosen
+			if (needed > budget) {
+				fprintf(stderr, "%s: Dictionary of %u records needs %.3f MB, more than the %.3f MB allowed\n", argv[0], dict_size, (double)needed/(1024*1024), (double)budget/(1024*1024));
+				fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+				goto error;
+			}
+		}
+		else if (((flags & MAX_MEMORY_FLAG) && !(flags & AUTO_SIZE_FLAG)) || needed > budget) {
+			size = memlimit_dict_size(budget, opts.growth, track, shared, &size_ht);
+			if (size == 0 || (df != NULL && size <= dictfile_first_record(df) + dictfile_records(df))) {
+				fprintf(stderr, "%s: %.3f MB of memory are not enough for a dictionary\n", argv[0], (double)budget/(1024*1024));
+				fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+				goto error;
+			}
+			dict_size = size;
+			ht_size = size_ht;
+		}
+		else if (!(flags & MAX_MEMORY_FLAG)) // the cgroup limit changed nothing
+			budget = 0;
+		opts.max_memory = budget;
+	}
+
+	// whole-byte codes are at most 24 bits: a given size is checked, a chosen one is reduced
+	if (opts.entropy == ENTROPY_BYTES && dict_size > ENTROPY_BYTES_MAX_SIZE && (flags & COMPRESS_FLAG)) {
+		if ((flags & DICT_SIZE_FLAG) && !(flags & AUTO_SIZE_FLAG)) {
+			fprintf(stderr, "%s: Dictionary size must be at most %d with --fast\n", argv[0], ENTROPY_BYTES_MAX_SIZE);
+			fprintf(stderr, "Try `%s -h' for more information\n", argv[0]);
+			goto error;
+		}
+		dict_size = ENTROPY_BYTES_MAX_SIZE;
+		if (!(flags & TABLE_SIZE_FLAG))
+			ht_size = dict_ht_size(dict_size, NUM_SYMBOLS);
+	}
+
+	if (flags & ESTIMATE_FLAG) { // pre-flight: nothing is compressed
+		print_memory_estimate(dict_size, ht_size, opts.growth, opts.reset_policy == RESET_POLICY_RECYCLE, df != NULL ? dictfile_memory(df) : 0);
+		dictfile_close(df);
+		exit(EXIT_SUCCESS);
+	}
+
 	if (out_file == NULL && (flags & ORIG_FILENAME_FLAG)) { // option -o without argument 
 		if (flags & COMPRESS_FLAG) { // compression: out_file will be stdin.lz78 or filename.lz78
 			if (in_file == NULL)
@@ -126,13 +397,23 @@ int main (int argc, char *argv[]) {
 			dec_flags |= DEC_ORIG_FILENAME;
 	}
 	
+	if (telemetry != NULL && telemetry_open(telemetry, telemetry_interval) < 0) {
+		perror(telemetry);
+		goto error;
+	}
+
 	print_infos(flags, in_file, out_file, dict_size, ht_size);
-	gettimeofday(&t1, NULL);
+	t1 = monotonic_time();
+	if (flags & PHASES_FLAG)
+		phase_enable();
 	
+	if (opts.reset_policy == RESET_POLICY_MANUAL) // reset on demand with kill -USR1
+		signal(SIGUSR1, reset_handler);
+
 	if (flags & COMPRESS_FLAG) 
-		filesize = compress(in_file, out_file, dict_size, ht_size, meta_flags);
+		filesize = compress(in_file, out_file, dict_size, ht_size, meta_flags, &opts);
 	else
-		filesize = decompress(in_file, out_file, dec_flags);
+		filesize = decompress(in_file, out_file, dec_flags, df, budget);
 	
 	if (filesize < 0) {
 		perror(flags & COMPRESS_FLAG ? "Compression Failed" : "Decompression Failed");
@@ -140,12 +421,19 @@ int main (int argc, char *argv[]) {
 	}
 	
 	print_stats(flags, in_file, out_file, filesize, t1);
+	STATS_PRINT(2);
+	if (flags & PHASES_FLAG)
+		phase_print(VERBOSE_STREAM, phases_json);
 
+	telemetry_close();
+	dictfile_close(df);
 	if (free_name == 1)
 		free(out_file);
 	exit(EXIT_SUCCESS);
 	
 error:
+	telemetry_close();
+	dictfile_close(df);
 	if (free_name == 1)
 		free(out_file);
 	exit(EXIT_FAILURE);
@@ -10,14 +10,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "dictionary.h"
 #include "main_utils.h"
+#include "memlimit.h"
 #include "verbose.h"
 
+struct timeval monotonic_time(void) {
+
+	struct timespec	ts;
+	struct timeval	t;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t.tv_sec = ts.tv_sec;
+	t.tv_usec = ts.tv_nsec / 1000;
+
+	return t;
+}
+
 struct timeval time_diff(struct timeval t2, struct timeval t1) {
 	t2.tv_sec -= t1.tv_sec;
 	t2.tv_usec -= t1.tv_usec;
@@ -58,6 +73,25 @@ char* print_time(struct timeval t) {
 
 int check_args(const char* name, int flags, const char* in_file, const char* out_file, uint32_t dict_size, uint32_t ht_size) {
 	
+	if (flags & TRAIN_FLAG) { // only the number of records, the samples and the output
+		if (flags & (COMPRESS_FLAG | DECOMPRESS_FLAG | AUTO_SIZE_FLAG | TABLE_SIZE_FLAG | RESET_POLICY_FLAG | GROWTH_FLAG | ENTROPY_FLAG | FAST_FLAG | SPARSE_FLAG | STORE_FLAG | DICT_FILE_FLAG)) {
+			fprintf(stderr, "%s: You can only specify -i, -o, -s and -v options with --train\n", name);
+			fprintf(stderr, "Try `%s -h' for more information\n", name);
+			return -1;
+		}
+		if (out_file == NULL) {
+			fprintf(stderr, "%s: You have to specify an output file with --train\n", name);
+			fprintf(stderr, "Try `%s -h' for more information\n", name);
+			return -1;
+		}
+		if ((flags & DICT_SIZE_FLAG) && (dict_size == 0 || dict_size > DICT_MAX_SIZE / 8)) {
+			fprintf(stderr, "%s: Invalid argument for number of records\n", name);
+			fprintf(stderr, "Try `%s -h' for more information\n", name);
+			return -1;
+		}
+		return 0;
+	}
+
 	if (in_file != NULL && out_file != NULL && strcmp(in_file, out_file) == 0) {
 		fprintf(stderr, "%s: You cannot specify the same argument for -i and -o option\n", name);
 		fprintf(stderr, "Try `%s -h' for more information\n", name);
@@ -88,7 +122,64 @@ int check_args(const char* name, int flags, const char* in_file, const char* out
 		return -1;
 	}
 	
+	if ((flags & DECOMPRESS_FLAG) && (flags & RESET_POLICY_FLAG)) { // decompression and reset policy setted together
+		fprintf(stderr, "%s: You cannot specify both -d and -r option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & ENTROPY_FLAG)) { // decompression and entropy coding setted together
+		fprintf(stderr, "%s: You cannot specify both -d and -e option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & FAST_FLAG)) { // decompression and byte-aligned codes setted together
+		fprintf(stderr, "%s: You cannot specify both -d and --fast option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & SPARSE_FLAG)) { // decompression and runs setted together
+		fprintf(stderr, "%s: You cannot specify both -d and --sparse option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & STORE_FLAG)) { // decompression and stored blocks setted together
+		fprintf(stderr, "%s: You cannot specify both -d and --store option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & ENTROPY_FLAG) && (flags & FAST_FLAG)) { // entropy coding and byte-aligned codes setted together
+		fprintf(stderr, "%s: You cannot specify both -e and --fast option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & ESTIMATE_FLAG)) { // decompression and memory estimate setted together
+		fprintf(stderr, "%s: You cannot specify both -d and --estimate-memory option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
+	if ((flags & DECOMPRESS_FLAG) && (flags & GROWTH_FLAG)) { // decompression and growth setted together
+		fprintf(stderr, "%s: You cannot specify both -d and -g option\n", name);
+		fprintf(stderr, "Try `%s -h' for more information\n", name);
+		return -1;
+	}
+	
 	if ((flags & DICT_SIZE_FLAG) || (flags & TABLE_SIZE_FLAG)) { // dict size or table size modified
+		if (flags & AUTO_SIZE_FLAG) { // dict size is chosen later, only table size can be checked
+			if ((flags & TABLE_SIZE_FLAG) && (ht_size < DICT_MIN_SIZE || ht_size > DICT_MAX_SIZE)) {
+				fprintf(stderr, "%s: Invalid arguments for hash table size\n", name);
+				fprintf(stderr, "Try `%s -h' for more information\n", name);
+				return -1;
+			}
+			return 0;
+		}
+
 		if (dict_size < DICT_MIN_SIZE || dict_size > DICT_MAX_SIZE) {
 			fprintf(stderr, "%s: Invalid argument for dictionary size\n", name);
 			fprintf(stderr, "Try `%s -h' for more information\n", name);
@@ -130,16 +221,32 @@ void print_infos(int flags, const char *in_file, const char *out_file, uint32_t
 	PRINT(1, "\n%s Started\n", flags & COMPRESS_FLAG ? "Compression" : "Decompression");
 }
 
+void print_memory_estimate(uint32_t dict_size, uint32_t ht_size, uint8_t growth, int track_uses, uint64_t shared) {
+
+	uint64_t comp, decomp;
+
+	comp = memlimit_needed(dict_size, ht_size, 1, growth, track_uses, shared);
+	decomp = memlimit_needed(dict_size, 0, 0, growth, track_uses, shared);
+
+	printf("Dictionary Size:\t%u\n", dict_size);
+	printf("Hash Table Size:\t%u\n", ht_size);
+	if (shared != 0)
+		printf("Dictionary File:\t%.3f MB\n", (double)shared/(1024*1024));
+	printf("Compression Memory:\t%.3f MB\n", (double)comp/(1024*1024));
+	printf("Decompression Memory:\t%.3f MB\n", (double)decomp/(1024*1024));
+}
+
 void print_stats(int flags, const char *in_file, const char *out_file, uint64_t filesize, struct timeval t1) {
 	
 	char 			*timestamp;
 	struct timeval	t2;
+	struct rusage	usage;
 	int				fd;
 	
 	if (VERBOSE_LEVEL < 1)
 		return;
 		
-	gettimeofday(&t2, NULL);
+	t2 = monotonic_time();
 	t2 = time_diff(t2, t1);
 	timestamp = print_time(t2);
 	
@@ -149,6 +256,10 @@ void print_stats(int flags, const char *in_file, const char *out_file, uint64_t
 		
 		PRINT(1, "Throughput:\t\t%.3f MB/s\n", (((double)filesize) / (((double)t2.tv_sec) + ((double)t2.tv_usec)/1000000)) / (1024*1024));
 		
+		if (getrusage(RUSAGE_SELF, &usage) == 0) { // ru_maxrss is in kilobytes
+			PRINT(1, "Peak Memory:\t\t%.3f MB\n", (double)usage.ru_maxrss/1024);
+		}
+		
 		if ((flags & COMPRESS_FLAG) && out_file != NULL) { // if outfile is stdout i cannot compute compression ratio
 			
 			fd = open(out_file, O_RDONLY);
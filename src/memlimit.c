@@ -0,0 +1,171 @@
+/**
+ * @file	memlimit.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for memory budgets: dictionary sizes that fit in a given amount of memory.
+ * @internal
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "debug.h"
+#include "dictionary.h"
+#include "memlimit.h"
+
+#define CGROUP_ROOT		"/sys/fs/cgroup"	/**< Where the cgroup file systems are mounted. */
+#define CGROUP_NO_LIMIT	((uint64_t)1 << 60)	/**< Limits from this value on mean no limit (cgroup v1 has no "max"). */
+
+/**
+ * Returns the lowest of the limits in files @p file of directory
+ * @p root/@p path and of the directories above it, up to @p root, or @c 0
+ * if none of them has a limit. A directory that does not exist (the cgroup
+ * path of another mount namespace) is skipped.
+ * @internal
+ */
+static uint64_t cgroup_limit(const char* root, char* path, const char* file) {
+
+	char		name[4096], value[32];
+	uint64_t	limit = 0, l;
+	FILE		*f;
+	char		*slash;
+
+	for (;;) {
+		snprintf(name, sizeof(name), "%s%s/%s", root, path, file);
+		f = fopen(name, "r");
+		if (f != NULL) {
+			if (fgets(value, sizeof(value), f) != NULL && isdigit((unsigned char)value[0])) { // else "max"
+				l = strtoull(value, NULL, 10);
+				if (l < CGROUP_NO_LIMIT && (limit == 0 || l < limit))
+					limit = l;
+			}
+			fclose(f);
+		}
+
+		slash = strrchr(path, '/');
+		if (slash == NULL)
+			break;
+		*slash = '\0';
+	}
+
+	return limit;
+}
+
+uint64_t memlimit_cgroup(void) {
+
+	char		line[4096], *controllers, *path, *p;
+	uint64_t	limit = 0, l = 0;
+	FILE		*f;
+
+	f = fopen("/proc/self/cgroup", "r");
+	if (f == NULL)
+		return 0;
+
+	// lines are hierarchy-ID:controller-list:cgroup-path, cgroup v2 has ID 0 and no controllers
+	while (fgets(line, sizeof(line), f) != NULL) {
+		line[strcspn(line, "\n")] = '\0';
+		controllers = strchr(line, ':');
+		if (controllers == NULL || (path = strchr(++controllers, ':')) == NULL)
+			continue;
+		*path++ = '\0';
+		if (strcmp(path, "/") == 0)
+			*path = '\0';
+
+		if (strcmp(line, "0:") == 0 && *controllers == '\0')
+			l = cgroup_limit(CGROUP_ROOT, path, "memory.max");
+		else {
+			for (p = strtok(controllers, ","); p != NULL && strcmp(p, "memory") != 0; p = strtok(NULL, ","));
+			if (p == NULL)
+				continue;
+			l = cgroup_limit(CGROUP_ROOT "/memory", path, "memory.limit_in_bytes");
+		}
+
+		if (l != 0 && (limit == 0 || l < limit))
+			limit = l;
+	}
+
+	fclose(f);
+	LOG("Cgroup memory limit: %llu", (unsigned long long)limit);
+
+	return limit;
+}
+
+int memlimit_parse(const char* str, uint64_t* bytes) {
+
+	double	size;
+	char	*end;
+	int		shift = 0;
+
+	if (str == NULL || !isdigit((unsigned char)*str))
+		return -1;
+
+	size = strtod(str, &end);
+	switch (toupper((unsigned char)*end)) {
+		case 'T': shift += 10; // fall through
+		case 'G': shift += 10; // fall through
+		case 'M': shift += 10; // fall through
+		case 'K': shift += 10;
+			end++;
+			if (*end == 'i')
+				end++;
+			break;
+	}
+	if (toupper((unsigned char)*end) == 'B')
+		end++;
+
+	size *= (double)((uint64_t)1 << shift);
+	if (*end != '\0' || size < 1 || size >= 18446744073709551616.0)
+		return -1;
+
+	*bytes = size;
+	return 0;
+}
+
+uint64_t memlimit_needed(uint32_t dict_size, uint32_t ht_size, int compression, uint8_t growth, int track_uses, uint64_t shared) {
+
+	uint64_t needed;
+
+	if (compression)
+		needed = dict_memory_estimate(dict_size, 1, ht_size, NUM_SYMBOLS, growth, track_uses);
+	else
+		needed = dict_memory_estimate(dict_size, 0, dict_size, NUM_SYMBOLS, growth, track_uses);
+
+	return needed != 0 ? needed + shared + MEMLIMIT_PROCESS : 0;
+}
+
+/**
+ * Returns the memory needed by the compressor or by the decompressor,
+ * whichever needs more, with a dictionary of @p size records.
+ * @internal
+ */
+static uint64_t needed_both(uint32_t size, uint8_t growth, int track_uses, uint64_t shared) {
+
+	uint64_t	comp = memlimit_needed(size, dict_ht_size(size, NUM_SYMBOLS), 1, growth, track_uses, shared);
+	uint64_t	decomp = memlimit_needed(size, 0, 0, growth, track_uses, shared);
+
+	return comp > decomp ? comp : decomp;
+}
+
+uint32_t memlimit_dict_size(uint64_t budget, uint8_t growth, int track_uses, uint64_t shared, uint32_t* ht_size) {
+
+	uint64_t	lo = DICT_MIN_SIZE, hi = DICT_MAX_SIZE, mid;
+
+	if (needed_both(lo, growth, track_uses, shared) > budget)
+		return 0;
+
+	// the memory needed grows with the size: find the largest that fits
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		if (needed_both(mid, growth, track_uses, shared) <= budget)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	*ht_size = dict_ht_size(lo, NUM_SYMBOLS);
+	return lo;
+}
@@ -11,6 +11,7 @@
 
 #include "common.h"
 #include "metadata.h"
+#include "probes.h"
 
 #define	min(a,b) ((a) < (b) ? (a) : (b))
 
@@ -37,8 +38,10 @@ void* meta_read(struct bitio *bd, uint8_t *type, uint8_t *size) {
 
 	*type = (uint8_t)tmp;
 
-	if (*type == 0)
+	if (*type == 0) {
+		PROBE2(meta_read, 0, 0);
 		return NULL;
+	}
 
 	// read metadata size
 	if (bitio_read(bd, &tmp, 8) != 8)
@@ -66,6 +69,7 @@ void* meta_read(struct bitio *bd, uint8_t *type, uint8_t *size) {
 		to_read -= read_step;
 	}
 
+	PROBE2(meta_read, *type, *size);
 	return data;
 
 error:
@@ -84,6 +88,8 @@ int meta_write(struct bitio *bd, uint8_t type, const void* data, uint8_t size) {
 		return -1;
 	}
 
+	PROBE2(meta_write, type, size);
+
 	// write metadata type
 	if (bitio_write(bd, type, 8) != 8)
 		return -1;
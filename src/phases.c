@@ -0,0 +1,165 @@
+/**
+ * @file	phases.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for the per-phase time and resource accounting of a run.
+ * @internal
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "phases.h"
+
+/**
+ * Usage of a phase, or snapshot of the usage of the process.
+ * @internal
+ */
+struct usage {
+	uint64_t	entries;	/**< Times the phase was entered (phases only). */
+	double		wall;		/**< Monotonic time, in seconds. */
+	double		user;		/**< User CPU time, in seconds. */
+	double		sys;		/**< System CPU time, in seconds. */
+	int64_t		nvcsw;		/**< Voluntary context switches. */
+	int64_t		nivcsw;		/**< Involuntary context switches. */
+	int64_t		minflt;		/**< Minor page faults. */
+	int64_t		majflt;		/**< Major page faults. */
+	int64_t		inblock;	/**< Blocks read from the file systems. */
+	int64_t		oublock;	/**< Blocks written to the file systems. */
+	int64_t		syscr;		/**< Read system calls. */
+	int64_t		syscw;		/**< Write system calls. */
+};
+
+static const char* const phase_names[PHASES] = { "metadata", "digest", "dictionary", "loop", "resets", "flush", "close" };
+
+static int			enabled = 0;			/**< Set by phase_enable(). */
+static int			current = PHASE_NONE;	/**< Phase being accounted. */
+static int			io_fd = -1;				/**< Descriptor of /proc/self/io, @c -1 if not available. */
+static struct usage	last;					/**< Snapshot taken when the current phase was entered. */
+static struct usage	phases[PHASES];			/**< Usage charged to each phase. */
+
+/**
+ * Returns the value of field @p name of the /proc/self/io contents @p buf.
+ * @internal
+ */
+static int64_t io_field(const char* buf, const char* name) {
+
+	const char *p = strstr(buf, name);
+
+	return p != NULL ? strtoll(p + strlen(name), NULL, 10) : 0;
+}
+
+/**
+ * Puts in @p u the usage of the process so far. System calls are read from
+ * /proc/self/io, and left at @c 0 where it is not available: that read is
+ * counted too, so each phase entry adds a read system call.
+ * @internal
+ */
+static void snapshot(struct usage* u) {
+
+	struct timespec	t;
+	struct rusage	r;
+	char			buf[256];
+	ssize_t			n;
+
+	memset(u, 0, sizeof(*u));
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	u->wall = t.tv_sec + t.tv_nsec / 1e9;
+
+	if (getrusage(RUSAGE_SELF, &r) == 0) {
+		u->user = r.ru_utime.tv_sec + r.ru_utime.tv_usec / 1e6;
+		u->sys = r.ru_stime.tv_sec + r.ru_stime.tv_usec / 1e6;
+		u->nvcsw = r.ru_nvcsw;
+		u->nivcsw = r.ru_nivcsw;
+		u->minflt = r.ru_minflt;
+		u->majflt = r.ru_majflt;
+		u->inblock = r.ru_inblock;
+		u->oublock = r.ru_oublock;
+	}
+
+	if (io_fd >= 0 && (n = pread(io_fd, buf, sizeof(buf) - 1, 0)) > 0) {
+		buf[n] = '\0';
+		u->syscr = io_field(buf, "syscr:");
+		u->syscw = io_field(buf, "syscw:");
+	}
+}
+
+void phase_enable(void) {
+
+	enabled = 1;
+	if (io_fd < 0)
+		io_fd = open("/proc/self/io", O_RDONLY);
+}
+
+void phase_enter(int phase) {
+
+	struct usage	now, *p;
+
+	if (!enabled)
+		return;
+
+	snapshot(&now);
+
+	if (current != PHASE_NONE) {
+		p = &phases[current];
+		p->wall += now.wall - last.wall;
+		p->user += now.user - last.user;
+		p->sys += now.sys - last.sys;
+		p->nvcsw += now.nvcsw - last.nvcsw;
+		p->nivcsw += now.nivcsw - last.nivcsw;
+		p->minflt += now.minflt - last.minflt;
+		p->majflt += now.majflt - last.majflt;
+		p->inblock += now.inblock - last.inblock;
+		p->oublock += now.oublock - last.oublock;
+		p->syscr += now.syscr - last.syscr;
+		p->syscw += now.syscw - last.syscw;
+	}
+
+	current = phase;
+	if (phase != PHASE_NONE)
+		phases[phase].entries++;
+
+	last = now;
+}
+
+void phase_print(FILE* f, int json) {
+
+	const struct usage	*p;
+	int					i, sep = 0;
+
+	if (json)
+		fprintf(f, "{\"phases\": {");
+	else
+		fprintf(f, "%-10s %7s %10s %10s %10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "Phase", "Entries", "Wall ms", "User ms",
+				"Sys ms", "Vol CS", "Invol CS", "Min PF", "Maj PF", "Blk In", "Blk Out", "Reads", "Writes");
+
+	for (i = 0; i < PHASES; i++) {
+		p = &phases[i];
+		if (p->entries == 0)
+			continue;
+
+		if (json)
+			fprintf(f, "%s\"%s\": {\"entries\": %llu, \"wall_ms\": %.3f, \"user_ms\": %.3f, \"sys_ms\": %.3f, "
+					"\"voluntary_switches\": %lld, \"involuntary_switches\": %lld, \"minor_faults\": %lld, "
+					"\"major_faults\": %lld, \"blocks_in\": %lld, \"blocks_out\": %lld, \"read_syscalls\": %lld, "
+					"\"write_syscalls\": %lld}", sep ? ", " : "", phase_names[i], (unsigned long long)p->entries,
+					p->wall * 1e3, p->user * 1e3, p->sys * 1e3, (long long)p->nvcsw, (long long)p->nivcsw,
+					(long long)p->minflt, (long long)p->majflt, (long long)p->inblock, (long long)p->oublock,
+					(long long)p->syscr, (long long)p->syscw);
+		else
+			fprintf(f, "%-10s %7llu %10.3f %10.3f %10.3f %8lld %8lld %8lld %8lld %8lld %8lld %8lld %8lld\n", phase_names[i],
+					(unsigned long long)p->entries, p->wall * 1e3, p->user * 1e3, p->sys * 1e3, (long long)p->nvcsw,
+					(long long)p->nivcsw, (long long)p->minflt, (long long)p->majflt, (long long)p->inblock,
+					(long long)p->oublock, (long long)p->syscr, (long long)p->syscw);
+		sep = 1;
+	}
+
+	if (json)
+		fprintf(f, "}}\n");
+}
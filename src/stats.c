@@ -0,0 +1,72 @@
+/**
+ * @file	stats.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for the hot path statistics of dictionary and coder.
+ * @internal
+ */
+
+#include "stats.h"
+
+#ifdef STATS
+
+struct stats stats_counters = { .load_min = 1 }; /**< Counters of the current run. */
+
+void stats_reset(uint64_t filled, uint64_t capacity) {
+
+	double load;
+
+	if (filled == 0 || capacity == 0)
+		return;
+
+	load = (double)filled / capacity;
+	stats_counters.resets++;
+	stats_counters.load_sum += load;
+	if (load < stats_counters.load_min)
+		stats_counters.load_min = load;
+	if (load > stats_counters.load_max)
+		stats_counters.load_max = load;
+}
+
+void stats_print(FILE* f) {
+
+	const struct stats	*s = &stats_counters;
+	uint64_t			codes = 0, sequences = s->hits + s->misses, hot = s->hot_hits + s->hot_misses;
+	int					i, sep;
+
+	for (i = 0; i < STATS_WIDTHS; i++)
+		codes += s->widths[i];
+
+	fprintf(f, "{\"hot_cache\": {\"hits\": %llu, \"misses\": %llu, \"hit_rate\": %.3f}",
+			(unsigned long long)s->hot_hits, (unsigned long long)s->hot_misses, hot ? (double)s->hot_hits / hot : 0);
+
+	fprintf(f, ", \"lookups\": {\"hits\": %llu, \"misses\": %llu, \"mean_skipped\": %.3f, \"skipped\": [",
+			(unsigned long long)s->hits, (unsigned long long)s->misses, sequences ? (double)s->skipped / sequences : 0);
+	for (i = 0; i < STATS_PROBES; i++)
+		fprintf(f, "%s%llu", i ? ", " : "", (unsigned long long)s->probes[i]);
+
+	fprintf(f, "]}, \"resets\": {\"count\": %llu, \"load_factor\": {\"min\": %.3f, \"mean\": %.3f, \"max\": %.3f}}",
+			(unsigned long long)s->resets, s->resets ? s->load_min : 0, s->resets ? s->load_sum / s->resets : 0, s->load_max);
+
+	fprintf(f, ", \"codes\": {\"count\": %llu, \"widths\": {", (unsigned long long)codes);
+	for (i = 0, sep = 0; i < STATS_WIDTHS; i++)
+		if (s->widths[i] != 0) {
+			fprintf(f, "%s\"%d\": %llu", sep ? ", " : "", i, (unsigned long long)s->widths[i]);
+			sep = 1;
+		}
+
+	fprintf(f, "}}, \"phrases\": {\"count\": %llu, \"bytes\": %llu, \"bytes_per_code\": %.3f, \"lengths\": {",
+			(unsigned long long)s->phrases, (unsigned long long)s->phrase_bytes, s->phrases ? (double)s->phrase_bytes / s->phrases : 0);
+	for (i = 0, sep = 0; i < STATS_DEPTHS; i++)
+		if (s->depths[i] != 0) { // bucket i holds lengths from 2^(i-1) to 2^i - 1
+			if (i <= 1)
+				fprintf(f, "%s\"%d\": %llu", sep ? ", " : "", i, (unsigned long long)s->depths[i]);
+			else
+				fprintf(f, "%s\"%llu-%llu\": %llu", sep ? ", " : "", 1ULL << (i - 1), (1ULL << i) - 1,
+						(unsigned long long)s->depths[i]);
+			sep = 1;
+		}
+	fprintf(f, "}}}\n");
+}
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file	telemetry.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Implementation file for telemetry module, machine readable progress records of a run.
+ * @internal
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "telemetry.h"
+
+/**
+ * State of the telemetry of the process.
+ * @internal
+ */
+static struct {
+	int			fd;			/**< Where records are written, @c -1 if telemetry is off. */
+	int			owned;		/**< Set if fd was opened by telemetry_open(). */
+	double		interval;	/**< Minimum time between two records, in seconds. */
+	const char	*mode;		/**< Mode of the current run. */
+	int			compress;	/**< Set if the current run compresses: the ratio is read over written bytes. */
+	uint64_t	total;		/**< Bytes the current run reads, @c 0 if unknown. */
+	double		start;		/**< Time the run started. */
+	double		last;		/**< Time of the previous record. */
+	uint64_t	last_in;	/**< Bytes read at the previous record. */
+} tm = { -1, 0, TELEMETRY_INTERVAL / 1e3, "", 0, 0, 0, 0, 0 };
+
+/**
+ * Returns the time of the monotonic clock, in seconds.
+ * @internal
+ */
+static double now(void) {
+
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * Writes a record at time @p t.
+ * @internal
+ */
+static void record(double t, uint64_t in, uint64_t out, uint32_t resets, int done) {
+
+	char		buf[512], eta[32];
+	double		mbps = 0;
+	uint64_t	orig = tm.compress ? in : out, coded = tm.compress ? out : in;
+	int			n;
+
+	if (t > tm.last)
+		mbps = (in - tm.last_in) / (t - tm.last) / (1024*1024);
+
+	if (done)
+		snprintf(eta, sizeof(eta), "0");
+	else if (tm.total != 0 && mbps > 0 && in <= tm.total)
+		snprintf(eta, sizeof(eta), "%.3f", (tm.total - in) / (mbps * 1024*1024));
+	else
+		snprintf(eta, sizeof(eta), "null");
+
+	n = snprintf(buf, sizeof(buf), "{\"mode\": \"%s\", \"time\": %.3f, \"bytes_in\": %llu, \"bytes_out\": %llu, "
+			"\"ratio\": %.3f, \"mbps\": %.3f, \"resets\": %u, \"eta\": %s, \"done\": %s}\n", tm.mode, t - tm.start,
+			(unsigned long long)in, (unsigned long long)out, coded ? (double)orig / coded : 0, mbps, resets, eta, done ? "true" : "false");
+
+	// a single write, so that a reader never sees half a record; a failure
+	// only loses the record, never the run
+	if (write(tm.fd, buf, n) != n)
+		LOG("Telemetry record not written");
+
+	tm.last = t;
+	tm.last_in = in;
+}
+
+int telemetry_open(const char* dest, uint32_t interval) {
+
+	const char *p;
+
+	if (dest == NULL || *dest == '\0' || interval == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (p = dest; isdigit((unsigned char)*p); p++);
+	if (*p == '\0') { // a file descriptor
+		tm.fd = atoi(dest);
+		tm.owned = 0;
+		if (fcntl(tm.fd, F_GETFD) < 0) {
+			tm.fd = -1;
+			return -1;
+		}
+	}
+	else {
+		tm.fd = open(dest, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if (tm.fd < 0)
+			return -1;
+		tm.owned = 1;
+	}
+	tm.interval = interval / 1e3;
+
+	return 0;
+}
+
+void telemetry_start(const char* mode, uint64_t total) {
+
+	if (tm.fd < 0)
+		return;
+
+	tm.mode = mode;
+	tm.compress = strcmp(mode, "compress") == 0;
+	tm.total = total;
+	tm.start = tm.last = now();
+	tm.last_in = 0;
+}
+
+void telemetry_update(uint64_t in, uint64_t out, uint32_t resets) {
+
+	double t;
+
+	if (tm.fd < 0)
+		return;
+
+	t = now();
+	if (t - tm.last >= tm.interval)
+		record(t, in, out, resets, 0);
+}
+
+void telemetry_end(uint64_t in, uint64_t out, uint32_t resets) {
+
+	if (tm.fd < 0)
+		return;
+
+	record(now(), in, out, resets, 1);
+}
+
+void telemetry_close(void) {
+
+	if (tm.fd >= 0 && tm.owned)
+		close(tm.fd);
+	tm.fd = -1;
+}
@@ -12,10 +12,15 @@
 
 #include "bitio.h"
 
+#define CODES	10000	/**< Codes of each width of TEST 2. */
+
 int main(int argc, char* argv[]) {
 	struct bitio *bd;
 	uint64_t d, r;
-	int i;
+	uint32_t codes[CODES];
+	uint8_t b;
+	int64_t n, j;
+	int i, w;
 
 	//TEST 1: writes 0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF23456789ABCDEF
 	if ((bd = bitio_open("bitio_test.dat", 'w')) == NULL) {
@@ -49,7 +54,47 @@ int main(int argc, char* argv[]) {
 	//delete file
 	unlink("bitio_test.dat");
 
-	//TEST 2: stdin and stdout
+	//TEST 2: codes of several widths, written and read in batches, some given back, then a byte at a byte boundary
+	if ((bd = bitio_open("bitio_test.dat", 'w')) == NULL) {
+		perror("bopen(w)");
+		exit(EXIT_FAILURE);
+	}
+	for (w = 1; w <= 32; w++) {
+		for (i = 0; i < CODES; i++)
+			codes[i] = (i * 0x9E3779B97F4A7C15ULL) >> (64 - w);
+		if (bitio_write_codes(bd, codes, CODES, w) != CODES)
+			exit(EXIT_FAILURE);
+		b = w;
+		if (bitio_align(bd) < 0 || bitio_write_bytes(bd, &b, 1) != 1)
+			exit(EXIT_FAILURE);
+	}
+	bitio_close(bd);
+
+	if ((bd = bitio_open("bitio_test.dat", 'r')) == NULL) {
+		perror("bopen(r)");
+		exit(EXIT_FAILURE);
+	}
+	for (w = 1; w <= 32; w++) {
+		for (i = 0; i < CODES; i += n) {
+			n = bitio_read_codes(bd, codes, CODES - i < 100 ? CODES - i : 100, w);
+			if (n <= 0)
+				exit(EXIT_FAILURE);
+			if (n > 1 && i % 3 == 0) { // give back all but the first one
+				if (bitio_unread(bd, (uint64_t)(n - 1) * w) < 0)
+					exit(EXIT_FAILURE);
+				n = 1;
+			}
+			for (j = 0; j < n; j++)
+				if (codes[j] != (uint32_t)(((i + j) * 0x9E3779B97F4A7C15ULL) >> (64 - w)))
+					exit(EXIT_FAILURE);
+		}
+		if (bitio_align(bd) < 0 || bitio_read_bytes(bd, &b, 1) != 1 || b != w)
+			exit(EXIT_FAILURE);
+	}
+	bitio_close(bd);
+	unlink("bitio_test.dat");
+
+	//TEST 3: stdin and stdout
 	while(bitio_read(bstdin, &r, 1) > 0) {
 		bitio_write(bstdout, r, 1);
 	}
@@ -0,0 +1,70 @@
+/**
+ * @file	test_entropy.c
+ * @author	Fabio Carrara, Daniele Formichelli
+ * @date	Oct 18, 2026
+ * @brief	Test file for entropy module, an adaptive range coder for dictionary codes.
+ * @internal
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "bitio.h"
+#include "entropy.h"
+
+#define CODES	100000
+#define FIRST	258
+
+/**
+ * Returns the @p i-th test code when @p n codes are valid: a symbol, one of
+ * the newest records or any record.
+ */
+static uint32_t test_code(int i, uint32_t n) {
+
+	uint32_t r = (uint32_t)i * 2654435761u;
+
+	if (i % 4 == 0 || n == FIRST)
+		return r % FIRST;
+	if (i % 2 == 0)
+		return n - 1 - r % (n - FIRST < 16 ? n - FIRST : 16);
+	return n - 1 - r % (n - FIRST);
+}
+
+int main(int argc, char* argv[]) {
+	struct bitio	*bd;
+	struct entropy	*e;
+	uint32_t		n, code;
+	int				i;
+
+	//TEST 1: writes codes of a growing dictionary, skewed towards the newest records
+	if ((bd = bitio_open("entropy_test.dat", 'w')) == NULL || (e = entropy_new(bd, 1, FIRST)) == NULL) {
+		perror("entropy_new(w)");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0, n = FIRST; i < CODES; i++, n++) {
+		if (entropy_put(e, test_code(i, n), n) < 0)
+			exit(EXIT_FAILURE);
+	}
+	if (entropy_flush(e) < 0)
+		exit(EXIT_FAILURE);
+	entropy_delete(e);
+	bitio_close(bd);
+
+	//TEST 2: reads them back
+	if ((bd = bitio_open("entropy_test.dat", 'r')) == NULL || (e = entropy_new(bd, 0, FIRST)) == NULL) {
+		perror("entropy_new(r)");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0, n = FIRST; i < CODES; i++, n++) {
+		if (entropy_get(e, n, &code) < 0 || code != test_code(i, n))
+			exit(EXIT_FAILURE);
+	}
+	entropy_delete(e);
+	bitio_close(bd);
+
+	//delete file
+	unlink("entropy_test.dat");
+
+	exit(EXIT_SUCCESS);
+}
@@ -6,12 +6,16 @@ INEX_FILE="non_existent"
 NAME_CHOSEN_FILE="ncf"
 COMPR_FILE_META="compressed_stuff.lz"
 COMPR_FILE_NO_META="compressed_stuff_stream.lz"
+DICT_FILE="stuff.lzd"
 SEED_FILE="stuff"
+SPARSE_FILE="sparse_stuff"
+RANDOM_FILE="random_stuff"
+LOG_FILE="log_stuff"
 
 EXE="../../lz78"
 
 echo -n "Cleaning previous stuff..."
-rm -f $EX_FILE.lz78 $COMPR_FILE_META $COMPR_FILE_NO_META $NAME_CHOSEN_FILE stdin*
+rm -f $EX_FILE.lz78 $COMPR_FILE_META $COMPR_FILE_NO_META $NAME_CHOSEN_FILE $DICT_FILE $SPARSE_FILE* $RANDOM_FILE* $LOG_FILE* stdin*
 echo "done"
 
 echo -n "Preparing stuff..."
@@ -37,6 +41,80 @@ $EXE -cvi $EX_FILE -o $NAME_CHOSEN_FILE
 echo "FILE -> AUTO FILE (w/ META_NAME, META_TS)"
 $EXE -cvi $EX_FILE -o
 
+echo "FILE -> NAME-CHOSEN FILE (auto dictionary size)"
+$EXE -cvi $EX_FILE -s auto -o $NAME_CHOSEN_FILE
+echo "STDIN -> STDOUT (auto dictionary size, not available)"
+cat $EX_FILE | $EXE -cv -s auto:memory > /dev/null
+echo "STDIN -> STDIN (lzap and lzmw growth)"
+cat $EX_FILE | $EXE -cv -g lzap | $EXE -dv | cmp - $EX_FILE
+cat $EX_FILE | $EXE -cv -g lzmw | $EXE -dv | cmp - $EX_FILE
+echo "STDIN -> STDIN (entropy coded)"
+cat $EX_FILE | $EXE -cv -e | $EXE -dv | cmp - $EX_FILE
+echo "STDIN -> STDIN (byte-aligned codes)"
+cat $EX_FILE | $EXE -cv --fast | $EXE -dv | cmp - $EX_FILE
+echo "STDIN -> STDIN (runs)"
+cat $EX_FILE | $EXE -cv --sparse | $EXE -dv | cmp - $EX_FILE
+echo "FILE -> FILE -> FILE (holes)"
+truncate -s 1M $SPARSE_FILE && cat $EX_FILE >> $SPARSE_FILE && truncate -s 3M $SPARSE_FILE
+$EXE -cvi $SPARSE_FILE -o $SPARSE_FILE.lz78
+$EXE -dvi $SPARSE_FILE.lz78 -o $SPARSE_FILE.out && cmp $SPARSE_FILE.out $SPARSE_FILE
+echo "STDIN -> STDIN (stored blocks)"
+head -c 100000 /dev/urandom > $RANDOM_FILE && cat $EX_FILE >> $RANDOM_FILE
+cat $RANDOM_FILE | $EXE -cv --store | $EXE -dv | cmp - $RANDOM_FILE
+cat $RANDOM_FILE | $EXE -cv --store --fast | $EXE -dv | cmp - $RANDOM_FILE
+echo "STDIN -> STDOUT (reset policies)"
+seq 1 12000 | awk '{ print "GET /item?id=" $1 % 97 " status=" ($1 * 7) % 5 " user=u" $1 % 13 }' > $LOG_FILE
+seq 1 60000 | awk '{ print "# " ($1 * 31) % 1009 " ; " $1 % 7 }' >> $LOG_FILE
+for POLICY in freeze adaptive adaptive:5; do
+	cat $EX_FILE | $EXE -c -s 4096 -r $POLICY | $EXE -d | cmp - $EX_FILE
+	cat $LOG_FILE | $EXE -c -s 4096 -r $POLICY | $EXE -d | cmp - $LOG_FILE
+done
+cat $EX_FILE | $EXE -c -s 4096 -r recycle | $EXE -d | cmp - $EX_FILE
+cat $EX_FILE | $EXE -c -s 1024 -r recycle --fast | $EXE -d | cmp - $EX_FILE
+cat $LOG_FILE | $EXE -c -s 4096 -r recycle | $EXE -d | cmp - $LOG_FILE
+cat $LOG_FILE | $EXE -c -s 1024 -r recycle --fast | $EXE -d | cmp - $LOG_FILE
+[ $(cat $LOG_FILE | $EXE -c -s 4096 -r adaptive | wc -c) -le $(cat $LOG_FILE | $EXE -c -s 4096 | wc -c) ] || echo "adaptive policy worse than reset"
+echo "STDIN -> STDIN (every vector kernel)"
+for SIMD in generic sse4.2 avx2 avx512; do
+	case $SIMD in
+		sse4.2) FLAGS="sse4_2" ;;
+		avx2) FLAGS="avx2" ;;
+		avx512) FLAGS="avx512f avx512bw" ;;
+		*) FLAGS="" ;;
+	esac
+	MISSING=""
+	for FLAG in $FLAGS; do
+		grep -qw $FLAG /proc/cpuinfo || MISSING="$MISSING $FLAG"
+	done
+	if [ -n "$MISSING" ]; then
+		echo "$SIMD skipped, the CPU lacks$MISSING"
+		continue
+	fi
+	cat $EX_FILE | LZ78_SIMD=$SIMD $EXE -c | $EXE -dv | cmp - $EX_FILE
+	cat $EX_FILE | LZ78_SIMD=$SIMD $EXE -c -s 4096 | cmp - <(cat $EX_FILE | LZ78_SIMD=generic $EXE -c -s 4096)
+done
+echo "STDIN -> STDOUT (unknown vector kernel)"
+cat $EX_FILE | LZ78_SIMD=sse9 $EXE -c | $EXE -d | cmp - $EX_FILE
+echo "FILES -> DICTIONARY FILE -> STDIN -> STDOUT (primed dictionary)"
+$EXE --train -v -s 1024 -o $DICT_FILE $SEED_FILE $EX_FILE
+cat $EX_FILE | $EXE -cv -D $DICT_FILE | $EXE -dv -D $DICT_FILE | cmp - $EX_FILE
+echo "STDIN -> STDOUT (primed dictionary, missing dictionary file)"
+cat $EX_FILE | $EXE -cv -D $DICT_FILE | $EXE -dv > /dev/null
+echo "STDIN -> STDOUT (phases report)"
+cat $EX_FILE | $EXE -c --phases | $EXE -d --phases=json | cmp - $EX_FILE
+echo "STDIN -> STDOUT (telemetry)"
+cat $EX_FILE | $EXE -c --telemetry 3 --telemetry-interval 10 3>&1 > /dev/null
+echo "MEMORY ESTIMATE (w/ DICT SIZE, RECYCLE)"
+$EXE -c -s 65536 -r recycle --estimate-memory
+echo "STDIN -> STDOUT (w/ MAX MEMORY)"
+cat $EX_FILE | $EXE -cv --max-memory 64M | $EXE -dv --max-memory 64M | cmp - $EX_FILE
+echo "STDIN -> STDOUT (w/ NOT ENOUGH MEMORY)"
+cat $EX_FILE | $EXE -c -s 4194304 -t 8388608 | $EXE -dv --max-memory 16M
+
+echo "STDIN -> STDOUT (missing argument)"
+cat $EX_FILE | $EXE -c --max-memory > /dev/null && echo "missing argument accepted"
+cat $EX_FILE | $EXE -c -g > /dev/null && echo "missing argument accepted"
+
 echo "INEXISTENT -> *"
 $EXE -ci $INEX_FILE -o
 
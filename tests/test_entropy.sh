@@ -0,0 +1,7 @@
+#!/bin/bash
+
+if build/test_entropy; then
+	exit 0;
+fi
+
+exit 1;